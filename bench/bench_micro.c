@@ -0,0 +1,321 @@
+// File: bench/bench_micro.c
+// Per-call cost of the hot paths, on the simulated GPIO backend. One CSV
+// line per benchmark so runs can be diffed between releases:
+//
+//   bench,ns_per_op,ops_per_s,iters
+//
+// bin/bench_micro [substring]   runs only the benchmarks whose name matches.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "gpio_backend.h"
+#include "gpio_mmio.h"
+#include "gpio_sim.h"
+#include "hx711_driver.h"
+#include "scale_filter.h"
+#include "scale_ring.h"
+#include "scale_state.h"
+#include "settle.h"
+#include "stepper_driver.h"
+
+#define PIN_STEP    24u
+#define PIN_DIR     23u
+#define PIN_EN      17u
+#define PIN_HOME    27u
+#define PIN_SCK     6u
+#define PIN_DOUT    5u
+
+#define TARGET_NS   (200u * 1000u * 1000u)     // run each benchmark for about this long
+
+typedef void (*bench_fn)(uint64_t iters);
+
+static volatile uint64_t sink;      // keeps results alive
+
+static uint64_t mono_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static const char *filter;
+
+// Grow the batch until it runs long enough to trust, then report that batch.
+static void run(const char *name, void (*setup)(void), bench_fn fn){
+    if (filter && !strstr(name, filter)) return;
+
+    uint64_t iters = 1, ns = 0;
+    for (;;) {
+        if (setup) setup();
+        uint64_t t0 = mono_ns();
+        fn(iters);
+        ns = mono_ns() - t0;
+        if (ns >= TARGET_NS || iters >= (1ull << 32)) break;
+        uint64_t grow = ns ? (TARGET_NS / ns) + 1u : 100u;
+        if (grow > 100u) grow = 100u;
+        if (grow < 2u) grow = 2u;
+        iters *= grow;
+    }
+    double per = (double)ns / (double)iters;
+    printf("%s,%.1f,%.0f,%llu\n", name, per, per > 0.0 ? 1e9 / per : 0.0, (unsigned long long)iters);
+    fflush(stdout);
+}
+
+// ---- stepper_update ----
+
+static stepper_motor m;
+static uint32_t m_next;
+
+static void sim_setup(void){
+    gpio_sim_config_t c = {
+        .step_line = PIN_STEP, .dir_line = PIN_DIR, .home_line = PIN_HOME,
+        .dir_positive_level = 1, .home_active_level = 0, .home_side = -1,
+        .home_pos_stp = INT32_MIN / 2,      // never trips
+        .sck_line = PIN_SCK, .dout_line = PIN_DOUT,
+        .hx_conv_period_us = 12500u,        // 80 SPS
+    };
+    gpio_sim_reset(&c);
+}
+
+static void motor_setup(void){
+    sim_setup();
+    m = (stepper_motor){
+        .gpiochip = "sim", .stp_per_rev = 8000u, .pulse_width_us = 10u,
+        .pul_pin = PIN_STEP, .dir_pin = PIN_DIR, .enable_pin = PIN_EN, .home_pin = PIN_HOME,
+    };
+    (void)stepper_init(&m);
+    (void)stepper_enable(&m);
+    m_next = 1000u;
+    (void)stepper_update(&m, m_next, &m_next);      // apply the enable
+    m.enabled_at_us = 0;
+}
+
+// every call lands on a due edge: the cruise-phase per-edge cost
+static void moving_setup(void){
+    motor_setup();
+    (void)stepper_queue_move_abs(&m, INT32_MAX / 2, 10000u, 10000u);
+    (void)stepper_update(&m, m_next, &m_next);
+}
+
+static void homing_setup(void){
+    motor_setup();
+    (void)stepper_queue_homing(&m, 10000u, 10000u, -1);
+    (void)stepper_update(&m, m_next, &m_next);
+}
+
+static void bench_update_edges(uint64_t iters){
+    uint32_t next = m_next;
+    for (uint64_t i = 0; i < iters; i++) (void)stepper_update(&m, next, &next);
+    m_next = next;
+}
+
+// called before the edge is due: the early-out path
+static void bench_update_early(uint64_t iters){
+    uint32_t next;
+    for (uint64_t i = 0; i < iters; i++) {
+        (void)stepper_update(&m, m.next_edge_us - 1u, &next);
+    }
+}
+
+static void bench_update_idle(uint64_t iters){
+    uint32_t next;
+    for (uint64_t i = 0; i < iters; i++) sink += (uint64_t)stepper_update(&m, (uint32_t)i, &next);
+}
+
+// pop a move, plan the ramp, set DIR and schedule the setup delay
+static void bench_update_start(uint64_t iters){
+    uint32_t next;
+    for (uint64_t i = 0; i < iters; i++) {
+        m.state = STP_ENABLED;
+        m.cur_pos_stp = 0;
+        (void)stepper_queue_move_abs(&m, (i & 1u) ? 1000 : -1000, 10000u, 10000u);
+        (void)stepper_update(&m, (uint32_t)i, &next);
+    }
+}
+
+// ---- HX711 ----
+
+static hx711_t h;
+
+static void hx_setup(void){
+    sim_setup();
+    h = (hx711_t){
+        .gpiochip = "sim", .sck_line = PIN_SCK, .dout_line = PIN_DOUT,
+        .tare_offset_cts = 1651769, .counts_per_kg = 951010.0f,
+    };
+    (void)hx711_init(&h);
+}
+
+static void bench_hx_read(uint64_t iters){
+    for (uint64_t i = 0; i < iters; i++) {
+        int32_t raw;
+        if (hx711_read_raw(&h, &raw) == 0) sink += (uint64_t)raw;
+    }
+}
+
+static void bench_raw_to_kg(uint64_t iters){
+    hx711_t c = { .tare_offset_cts = 1651769, .counts_per_kg = 951010.0f };
+    float acc = 0.0f;
+    for (uint64_t i = 0; i < iters; i++) acc += hx711_raw_to_kg(&c, (int32_t)(1651769u + (i & 0xFFFFu)));
+    sink += (uint64_t)acc;
+}
+
+// ---- register-mapped backend, on a plain file standing in for the window ----
+
+static char mmio_file[64];
+static void *mmio_line;
+
+static int mmio_setup_file(void){
+    if (!mmio_file[0]) {
+        snprintf(mmio_file, sizeof(mmio_file), "/tmp/bench_mmio.XXXXXX");
+        int fd = mkstemp(mmio_file);
+        if (fd < 0 || ftruncate(fd, GPIO_MMIO_WINDOW_LEN) < 0) {
+            if (fd >= 0) close(fd);
+            mmio_file[0] = '\0';
+            return -1;
+        }
+        close(fd);
+    }
+    if (gpio_mmio_open(mmio_file, NULL) < 0) return -1;
+    gpio_set_backend(&gpio_mmio_backend);
+    return 0;
+}
+
+static void mmio_setup(void){
+    if (mmio_setup_file() < 0) { mmio_line = NULL; return; }
+    void *chip = gpio_chip_open("mmio");
+    mmio_line = gpio_request_output(chip, PIN_STEP, "bench", 0);
+}
+
+static void bench_mmio_set(uint64_t iters){
+    if (!mmio_line) return;
+    for (uint64_t i = 0; i < iters; i++) (void)gpio_set_value(mmio_line, (int)(i & 1u));
+}
+
+static void hx_mmio_setup(void){
+    if (mmio_setup_file() < 0) return;
+    h = (hx711_t){
+        .gpiochip = "mmio", .sck_line = PIN_SCK, .dout_line = PIN_DOUT,
+        .tare_offset_cts = 1651769, .counts_per_kg = 951010.0f,
+    };
+    (void)hx711_init(&h);
+}
+
+// ---- scale pipeline ----
+
+static scale_ring_t ring;
+static scale_filter_t flt;
+static settle_t stl;
+
+static void ring_setup(void){
+    memset(&ring, 0, sizeof(ring));
+    for (uint32_t i = 0; i < SCALE_RING_LEN; i++) scale_ring_push(&ring, (int32_t)i, 0.5f, i);
+}
+
+static void bench_ring_push(uint64_t iters){
+    for (uint64_t i = 0; i < iters; i++) scale_ring_push(&ring, (int32_t)i, 0.5f, i);
+}
+
+static scale_state_t state;
+
+static void state_setup(void){
+    memset(&state, 0, sizeof(state));
+    scale_state_publish(&state, 1, 0.5f, 1u);
+}
+
+static void bench_state_publish(uint64_t iters){
+    for (uint64_t i = 0; i < iters; i++) scale_state_publish(&state, (int32_t)i, 0.5f, i);
+}
+
+static void bench_state_get(uint64_t iters){
+    scale_snapshot_t s;
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        scale_state_get(&state, &s);
+        acc += s.seq;
+    }
+    sink += acc;
+}
+
+// the control loop's ring drain: copy 16 conversions out and accumulate
+// them as deposit_feed() does while WEIGHING
+static void bench_deposit_drain16(uint64_t iters){
+    uint32_t head = scale_ring_seq(&ring);
+    double sum = 0.0;
+    for (uint64_t i = 0; i < iters; i++) {
+        scale_sample_t buf[16];
+        size_t k = scale_ring_since(&ring, head - 16u, buf, 16u);
+        for (size_t j = 0; j < k; j++) sum += (double)buf[j].kg;
+    }
+    sink += (uint64_t)sum;
+}
+
+static void filter_setup(void){
+    scale_filter_cfg_t c;
+    scale_filter_cfg_defaults(&c);
+    (void)scale_filter_parse_chain(&c, "mad,median,ema");
+    scale_filter_init(&flt, &c);
+}
+
+static void bench_filter(uint64_t iters){
+    int32_t out = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        int32_t x = 1651769 + (int32_t)((i * 2654435761u) & 0x1FFu);
+        (void)scale_filter_process(&flt, x, &out);
+    }
+    sink += (uint64_t)out;
+}
+
+static void settle_setup(void){
+    settle_cfg_t c = { .window = 8u, .band_kg = 0.002f, .slope_kg_s = 0.01f, .max_ms = 2000u };
+    settle_init(&stl, &c);
+}
+
+static void bench_settle(uint64_t iters){
+    int r = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        r += settle_push(&stl, 0.5f + (float)(i & 7u) * 1e-4f, i * 12500000u);
+    }
+    sink += (uint64_t)r;
+}
+
+// ---- config ----
+
+static void bench_config_load(uint64_t iters){
+    app_config_t c;
+    for (uint64_t i = 0; i < iters; i++) {
+        config_set_defaults(&c);
+        sink += (uint64_t)(config_load_file(&c, "config.txt") + 2);
+    }
+}
+
+int main(int argc, char **argv){
+    filter = (argc > 1) ? argv[1] : NULL;
+    gpio_set_backend(&gpio_sim_backend);
+
+    printf("bench,ns_per_op,ops_per_s,iters\n");
+    run("stepper_update.moving_edge",  moving_setup, bench_update_edges);
+    run("stepper_update.homing_edge",  homing_setup, bench_update_edges);
+    run("stepper_update.not_due",      moving_setup, bench_update_early);
+    run("stepper_update.start_dir_setup", motor_setup, bench_update_start);
+    run("stepper_update.idle",         motor_setup,  bench_update_idle);
+    run("hx711_read_raw.sim",          hx_setup,     bench_hx_read);
+    run("hx711_raw_to_kg",             NULL,         bench_raw_to_kg);
+    run("gpio_set_value.mmio_file",    mmio_setup,   bench_mmio_set);
+    run("hx711_read_raw.mmio_file",    hx_mmio_setup, bench_hx_read);
+    gpio_set_backend(&gpio_sim_backend);
+    gpio_mmio_close();
+    if (mmio_file[0]) unlink(mmio_file);
+    run("scale_ring_push",             ring_setup,   bench_ring_push);
+    run("deposit.drain16_from_ring",   ring_setup,   bench_deposit_drain16);
+    run("scale_state_publish",         state_setup,  bench_state_publish);
+    run("scale_state_get",             state_setup,  bench_state_get);
+    run("scale_filter.mad_median_ema", filter_setup, bench_filter);
+    run("settle_push.w8",              settle_setup, bench_settle);
+    run("config_load_file",            NULL,         bench_config_load);
+    return 0;
+}
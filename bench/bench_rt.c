@@ -0,0 +1,233 @@
+// File: bench/bench_rt.c
+// cyclictest-style check of the real stepper thread: same RT setup, same
+// tick loop, simulated (cost-free) GPIO, optional stress load alongside.
+//
+//   make bench-rt RT_ARGS="-d 60 -p 80 -c 2 -s cpu,mem,io"
+//   make bench-rt RT_ARGS="-d 20 -x 3"     # three axes on the one RT thread
+//
+// Needs CAP_SYS_NICE (or root) for SCHED_FIFO; without it the numbers show
+// what an unprivileged thread gets.
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "gpio_backend.h"
+#include "gpio_sim.h"
+#include "stepper_driver.h"
+#include "stepper_thread.h"
+
+#define PIN_STEP    24u
+#define PIN_DIR     23u
+#define PIN_EN      17u
+#define PIN_HOME    27u
+#define PIN_AXIS(i) (32u + 4u * (unsigned)(i))  // extra axes: step, dir, en, home from here
+
+#define TRACE_MAX       (4u * 1024u * 1024u)
+#define MEM_STRESS_LEN  (64u * 1024u * 1024u)
+#define IO_STRESS_LEN   (1024u * 1024u)
+
+static atomic_int stress_run = 1;
+
+static void* stress_cpu(void *p){
+    (void)p;
+    volatile uint64_t x = 1;
+    while (atomic_load_explicit(&stress_run, memory_order_relaxed)) {
+        for (int i = 0; i < 100000; i++) x = x * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return NULL;
+}
+
+static void* stress_mem(void *p){
+    (void)p;
+    char *a = malloc(MEM_STRESS_LEN), *b = malloc(MEM_STRESS_LEN);
+    if (!a || !b) { free(a); free(b); return NULL; }
+    memset(a, 1, MEM_STRESS_LEN);
+    while (atomic_load_explicit(&stress_run, memory_order_relaxed)) {
+        memcpy(b, a, MEM_STRESS_LEN);
+        memcpy(a, b, MEM_STRESS_LEN);
+    }
+    free(a);
+    free(b);
+    return NULL;
+}
+
+static void* stress_io(void *p){
+    (void)p;
+    char path[] = "/tmp/bench_rt_io.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("stress io"); return NULL; }
+    unlink(path);
+    char *buf = malloc(IO_STRESS_LEN);
+    if (!buf) { close(fd); return NULL; }
+    memset(buf, 0x5a, IO_STRESS_LEN);
+    while (atomic_load_explicit(&stress_run, memory_order_relaxed)) {
+        if (pwrite(fd, buf, IO_STRESS_LEN, 0) < 0) break;
+        (void)fsync(fd);
+    }
+    free(buf);
+    close(fd);
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b){
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double pct_us(const uint32_t *v, size_t n, double q){
+    if (n == 0) return 0.0;
+    size_t i = (size_t)((double)(n - 1u) * q);
+    return (double)v[i] * 1e-3;
+}
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+            "usage: %s [-d seconds] [-p rt_priority] [-c cpu] [-s cpu,mem,io] [-n threads per stressor]\n"
+            "          [-S stress_cpu] [-v speed_sps] [-a acc_sps2] [-m stroke_steps] [-x axes]\n", argv0);
+}
+
+int main(int argc, char **argv){
+    int seconds = 10, prio = 80, cpu = 2, per_kind = 1, stress_cpu_pin = -1, axes = 1;
+    uint32_t speed = 10000u, acc = 10000u;
+    int32_t stroke = 4000;
+    const char *stress = "";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:p:c:s:n:S:v:a:m:x:h")) != -1) {
+        switch (opt) {
+        case 'd': seconds = atoi(optarg); break;
+        case 'p': prio = atoi(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 's': stress = optarg; break;
+        case 'n': per_kind = atoi(optarg); break;
+        case 'S': stress_cpu_pin = atoi(optarg); break;
+        case 'v': speed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'a': acc = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'm': stroke = (int32_t)strtol(optarg, NULL, 0); break;
+        case 'x': axes = atoi(optarg); break;
+        default:  usage(argv[0]); return 2;
+        }
+    }
+    if (seconds <= 0 || per_kind <= 0 || speed == 0 || stroke == 0 ||
+        axes < 1 || axes > (int)STEPPER_THREAD_MAX_AXES) { usage(argv[0]); return 2; }
+
+    gpio_sim_config_t cfg = {
+        .step_line = PIN_STEP, .dir_line = PIN_DIR, .home_line = PIN_HOME,
+        .dir_positive_level = 1, .home_active_level = 0, .home_side = -1,
+        .home_pos_stp = INT32_MIN / 2,
+    };
+    gpio_sim_reset(&cfg);
+    gpio_set_backend(&gpio_sim_backend);
+
+    // axis 0 is the modelled motor, the others drive plain latches
+    stepper_motor m[STEPPER_THREAD_MAX_AXES];
+    stepper_motor *mp[STEPPER_THREAD_MAX_AXES];
+    for (int i = 0; i < axes; i++) {
+        unsigned base = PIN_AXIS(i);
+        m[i] = (stepper_motor){
+            .gpiochip = "sim", .stp_per_rev = 8000u, .pulse_width_us = 10u,
+            .pul_pin  = (uint8_t)(i ? base : PIN_STEP),      .dir_pin  = (uint8_t)(i ? base + 1u : PIN_DIR),
+            .enable_pin = (uint8_t)(i ? base + 2u : PIN_EN), .home_pin = (uint8_t)(i ? base + 3u : PIN_HOME),
+        };
+        if (stepper_init(&m[i]) < 0) { fprintf(stderr, "stepper_init failed\n"); return 1; }
+        mp[i] = &m[i];
+    }
+
+    uint32_t *trace = malloc(TRACE_MAX * sizeof(uint32_t));
+    if (!trace) return 1;
+    stepper_thread_trace(trace, TRACE_MAX);
+
+    // stress first, so the RT thread starts under load
+    pthread_t th[64];
+    int nth = 0;
+    const struct { const char *name; void *(*fn)(void*); } kinds[] = {
+        { "cpu", stress_cpu }, { "mem", stress_mem }, { "io", stress_io },
+    };
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        if (!strstr(stress, kinds[k].name)) continue;
+        for (int i = 0; i < per_kind && nth < 64; i++) {
+            if (pthread_create(&th[nth], NULL, kinds[k].fn, NULL) != 0) continue;
+#ifdef __linux__
+            if (stress_cpu_pin >= 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET((unsigned)stress_cpu_pin, &set);
+                (void)pthread_setaffinity_np(th[nth], sizeof(set), &set);
+            }
+#endif
+            nth++;
+        }
+    }
+
+    volatile sig_atomic_t running = 1;
+    if (stepper_thread_start_axes(&running, mp, (size_t)axes, prio, cpu) != 0) {
+        fprintf(stderr, "thread start failed\n");
+        return 1;
+    }
+    for (int i = 0; i < axes; i++) (void)stepper_enable(&m[i]);
+
+    // keep the motors busy: back and forth strokes for the whole run, each
+    // axis at its own speed so their edges drift against each other
+    struct timespec t0, now;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int leg = 0;
+    uint32_t strokes = 0;
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec - t0.tv_sec >= seconds) break;
+        uint32_t seq[STEPPER_THREAD_MAX_AXES];
+        int ok = 1;
+        for (int i = 0; i < axes; i++) {
+            uint32_t v = speed + (uint32_t)((uint64_t)speed * (uint32_t)i * 13u / 100u);
+            seq[i] = stepper_queue_move_abs(&m[i], leg ? 0 : stroke, v, acc);
+        }
+        for (int i = 0; i < axes; i++) {
+            if (seq[i] == 0 || stepper_wait_done(&m[i], seq[i], 60000u) != 0) ok = 0;
+        }
+        leg ^= 1;
+        if (!ok) break;
+        strokes++;
+    }
+
+    running = 0;
+    stepper_thread_join();
+    atomic_store(&stress_run, 0);
+    for (int i = 0; i < nth; i++) pthread_join(th[i], NULL);
+
+    stepper_rt_stats_t st;
+    stepper_thread_get_stats(&st);
+    size_t n = stepper_thread_trace_len();
+    qsort(trace, n, sizeof(trace[0]), cmp_u32);
+
+    printf("bench_rt: seconds=%d rt_priority=%d cpu=%d stress=%s x%d axes=%d strokes=%u\n",
+           seconds, prio, cpu, stress[0] ? stress : "none", per_kind, axes, strokes);
+    printf("wake_latency_us: n=%zu min=%.1f avg=%.1f p50=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+           n, (double)st.wake_min_ns * 1e-3,
+           st.wakeups ? (double)st.wake_sum_ns / (double)st.wakeups * 1e-3 : 0.0,
+           pct_us(trace, n, 0.50), pct_us(trace, n, 0.99), pct_us(trace, n, 0.999),
+           (double)st.wake_max_ns * 1e-3);
+    printf("step_edges: n=%llu late_gt_%uus=%llu (%.3f%%) avg_late_us=%.2f max_late_us=%llu missed=%llu\n",
+           (unsigned long long)st.edges, STEPPER_RT_LATE_EDGE_US, (unsigned long long)st.late_edges,
+           st.edges ? 100.0 * (double)st.late_edges / (double)st.edges : 0.0,
+           st.edges ? (double)st.edge_late_sum_us / (double)st.edges : 0.0,
+           (unsigned long long)st.edge_late_max_us, (unsigned long long)st.missed);
+    printf("wakeups: n=%llu per_s=%.0f edges_per_wakeup=%.2f coalesced=%llu idle=%llu\n",
+           (unsigned long long)st.wakeups, (double)st.wakeups / (double)seconds,
+           st.wakeups ? (double)st.edges / (double)st.wakeups : 0.0, (unsigned long long)st.coalesced,
+           (unsigned long long)st.idle_wakeups);
+    printf("update_exec_ns: p99<=%llu max=%llu\n",
+           (unsigned long long)stepper_rt_hist_quantile(st.exec_hist, 0.99),
+           (unsigned long long)st.exec_max_ns);
+
+    free(trace);
+    return 0;
+}
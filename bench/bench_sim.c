@@ -0,0 +1,410 @@
+// File: bench/bench_sim.c
+// Faster-than-real-time timing harness: runs stepper_update() and
+// hx711_read_raw() against the simulated GPIO backend on a virtual clock.
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+
+#include "gpio_sim.h"
+#include "stepper_driver.h"
+#include "hx711_driver.h"
+#include "deposit.h"
+#include "zero_track.h"
+
+#define SIM_OP_COST_NS      1500u   // roughly one libgpiod ioctl on a Pi 5
+#define SIM_TIMEOUT_US      (30u * 1000000u)
+
+#define PIN_STEP    24u
+#define PIN_DIR     23u
+#define PIN_EN      17u
+#define PIN_HOME    27u
+#define PIN_SCK     6u
+#define PIN_DOUT    5u
+#define PIN_DOUT_MORE(i)    (40u + (unsigned)(i))   // channels 1.. of the shared-SCK bench
+
+typedef struct {
+    uint64_t n;
+    int64_t  min, max, sum;
+} stat_t;
+
+static void stat_add(stat_t *s, int64_t v){
+    if (s->n == 0 || v < s->min) s->min = v;
+    if (s->n == 0 || v > s->max) s->max = v;
+    s->sum += v;
+    s->n++;
+}
+
+static double stat_avg(const stat_t *s){
+    return s->n ? (double)s->sum / (double)s->n : 0.0;
+}
+
+static double wall_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static gpio_sim_config_t sim_config(void){
+    static const int32_t counts[] = {
+        1651769, 1651769 + 95101, 1651769 - 4000, 0x7FFFFF, -0x800000, 0, -1, 1748000,
+    };
+    gpio_sim_config_t c = {
+        .op_cost_ns         = SIM_OP_COST_NS,
+        .step_line          = PIN_STEP,
+        .dir_line           = PIN_DIR,
+        .home_line          = PIN_HOME,
+        .dir_positive_level = 1,
+        .home_active_level  = 0,
+        .home_side          = -1,
+        .home_pos_stp       = -800,
+        .sck_line           = PIN_SCK,
+        .dout_line          = PIN_DOUT,
+        .hx_conv_period_us  = 100000u,
+        .hx_counts          = counts,
+        .hx_count_n         = sizeof(counts) / sizeof(counts[0]),
+    };
+    return c;
+}
+
+static stepper_motor sim_motor(void){
+    stepper_motor m = {
+        .gpiochip = "sim",
+        .stp_per_rev = 8000u,
+        .pulse_width_us = 10u,
+        .pul_pin = PIN_STEP,
+        .dir_pin = PIN_DIR,
+        .enable_pin = PIN_EN,
+        .home_pin = PIN_HOME,
+        .home_active_level = 0,
+        .dir_invert = 0,
+        .en_active_level = 0,
+    };
+    return m;
+}
+
+static uint32_t sim_now_us(void){
+    return (uint32_t)(gpio_sim_now_ns() / 1000u);
+}
+
+// Drive stepper_update() the way stepper_thread_fn does: sleep until the
+// edge it asks for, stop when it reports idle.
+static void run_stepper(stepper_motor *m, const char *label){
+    stat_t edge_err = {0}, step_iv = {0};
+    gpio_sim_stats_t st;
+    gpio_sim_get_stats(&st);
+    uint64_t steps0 = st.step_edges, last_step = 0, first_step = 0;
+    uint64_t calls = 0;
+    uint64_t io0 = m->io_calls;
+
+    uint64_t t0 = gpio_sim_now_ns();
+    double w0 = wall_s();
+
+    while ((gpio_sim_now_ns() - t0) / 1000u < SIM_TIMEOUT_US) {
+        uint32_t due = m->next_edge_us;
+        uint8_t level = m->step_level;
+        uint32_t now = sim_now_us();
+
+        uint32_t next_us;
+        int busy = stepper_update(m, now, &next_us);
+        calls++;
+
+        if (m->step_level != level && due != 0) stat_add(&edge_err, (int32_t)(now - due));
+
+        gpio_sim_get_stats(&st);
+        if (st.last_step_ns != last_step && st.step_edges != steps0) {
+            if (last_step != 0) stat_add(&step_iv, (int64_t)(st.last_step_ns - last_step));
+            else first_step = st.last_step_ns;
+            last_step = st.last_step_ns;
+        }
+
+        if (!busy) break;
+
+        // absolute sleep until the requested edge
+        int32_t wait_us = (int32_t)(next_us - sim_now_us());
+        if (wait_us > 0) gpio_sim_advance_ns((uint64_t)wait_us * 1000u);
+    }
+
+    double wall = wall_s() - w0;
+    double virt = (double)(gpio_sim_now_ns() - t0) * 1e-9;
+    uint64_t steps = st.step_edges - steps0;
+    double span = (last_step > first_step) ? (double)(last_step - first_step) * 1e-9 : 0.0;
+
+    printf("%s: steps=%llu pos=%ld virt=%.3f s wall=%.4f s speedup=%.0fx wakeups=%llu (%.2f/step)\n",
+           label, (unsigned long long)steps, (long)st.pos_stp, virt, wall,
+           wall > 0.0 ? virt / wall : 0.0, (unsigned long long)calls,
+           steps ? (double)calls / (double)steps : 0.0);
+    printf("%s: avg_rate=%.0f sps peak_rate=%.0f sps gpio_calls=%llu (%.2f/step)\n", label,
+           span > 0.0 ? (double)(steps - 1) / span : 0.0,
+           step_iv.min > 0 ? 1e9 / (double)step_iv.min : 0.0,
+           (unsigned long long)(m->io_calls - io0),
+           steps ? (double)(m->io_calls - io0) / (double)steps : 0.0);
+    printf("%s: edge_err_us min=%lld avg=%.2f max=%lld (n=%llu)\n", label,
+           (long long)edge_err.min, stat_avg(&edge_err), (long long)edge_err.max,
+           (unsigned long long)edge_err.n);
+}
+
+static void bench_move(int32_t target, uint32_t speed_sps, uint32_t acc_sps2){
+    gpio_sim_config_t cfg = sim_config();
+    gpio_sim_reset(&cfg);
+
+    stepper_motor m = sim_motor();
+    if (stepper_init(&m) < 0 || stepper_enable(&m) < 0) { fprintf(stderr, "move: init failed\n"); return; }
+    if (stepper_start_move_abs(&m, target, speed_sps, acc_sps2) < 0) return;
+
+    char label[64];
+    snprintf(label, sizeof(label), "move[%ld@%lu/%lu]", (long)target,
+             (unsigned long)speed_sps, (unsigned long)acc_sps2);
+    run_stepper(&m, label);
+}
+
+// Out-and-back deposit stroke: queued back to back vs. the old start/poll/start.
+static void bench_stroke(int32_t stroke, uint32_t speed_sps, uint32_t acc_sps2, uint32_t poll_us){
+    gpio_sim_config_t cfg = sim_config();
+    gpio_sim_reset(&cfg);
+
+    stepper_motor m = sim_motor();
+    if (stepper_init(&m) < 0 || stepper_enable(&m) < 0) { fprintf(stderr, "stroke: init failed\n"); return; }
+    uint32_t nx;
+    (void)stepper_update(&m, sim_now_us(), &nx);   // apply the enable, then skip its settle time
+    m.enabled_at_us = 0;
+
+    uint64_t t0 = gpio_sim_now_ns();
+    (void)stepper_queue_move_abs(&m, stroke, speed_sps, acc_sps2);
+    uint32_t back = stepper_queue_move_abs(&m, 0, speed_sps, acc_sps2);
+    run_stepper(&m, "stroke[queued]");
+    double queued_ms = (double)(gpio_sim_now_ns() - t0) * 1e-6;
+
+    t0 = gpio_sim_now_ns();
+    for (int leg = 0; leg < 2; leg++) {
+        (void)stepper_start_move_abs(&m, leg ? 0 : stroke, speed_sps, acc_sps2);
+        run_stepper(&m, leg ? "stroke[polled back]" : "stroke[polled out]");
+        // the control thread only notices on its next poll
+        uint64_t since = gpio_sim_now_ns() - t0;
+        uint64_t poll_ns = (uint64_t)poll_us * 1000u;
+        gpio_sim_advance_ns(poll_ns - since % poll_ns);
+    }
+    double polled_ms = (double)(gpio_sim_now_ns() - t0) * 1e-6;
+
+    printf("stroke: done=%d queued=%.2f ms polled(%lu us)=%.2f ms saved=%.2f ms\n",
+           stepper_seq_done(&m, back), queued_ms, (unsigned long)poll_us, polled_ms, polled_ms - queued_ms);
+}
+
+static void bench_homing(uint32_t speed_sps, uint32_t acc_sps2){
+    gpio_sim_config_t cfg = sim_config();
+    gpio_sim_reset(&cfg);
+
+    stepper_motor m = sim_motor();
+    if (stepper_init(&m) < 0 || stepper_enable(&m) < 0) { fprintf(stderr, "homing: init failed\n"); return; }
+    if (stepper_start_homing(&m, speed_sps, acc_sps2, -1) < 0) return;
+
+    run_stepper(&m, "homing");
+
+    gpio_sim_stats_t st;
+    gpio_sim_get_stats(&st);
+    printf("homing: homed=%u switch_at=%ld overshoot=%ld steps\n", (unsigned)m.homed,
+           (long)cfg.home_pos_stp, (long)(cfg.home_pos_stp - st.pos_stp));
+}
+
+// channels > 1: that many identical chips on one SCK, read as a group;
+// sps 80 runs the ADC with RATE high (the driver should measure it)
+static void bench_hx711(uint32_t n_reads, int edge_events, unsigned channels,
+                        hx711_gain_t gain, unsigned sps){
+    gpio_sim_config_t cfg = sim_config();
+    cfg.no_edge_events = (uint8_t)!edge_events;
+    cfg.hx_conv_period_us = 1000000u / sps;
+    for (unsigned i = 1; i < channels; i++) cfg.hx_dout_mirror |= 1ull << PIN_DOUT_MORE(i);
+    gpio_sim_reset(&cfg);
+    char label[32];
+    if (channels > 1u) snprintf(label, sizeof(label), "hx711[x%u]", channels);
+    else if (gain != HX711_GAIN_A128 || sps != 10u) snprintf(label, sizeof(label), "hx711[%s,%u]",
+                                                             gain == HX711_GAIN_A64 ? "a64" : "b32", sps);
+    else snprintf(label, sizeof(label), "%s", edge_events ? "hx711[edge]" : "hx711[poll]");
+
+    hx711_t h = {
+        .gpiochip = "sim",
+        .sck_line = PIN_SCK,
+        .dout_line = PIN_DOUT,
+        .tare_offset_cts = 1651769,
+        .counts_per_kg = 951010.0f,
+        .gain = (uint8_t)gain,
+        .channels = (uint8_t)channels,
+    };
+    for (unsigned i = 1; i < channels; i++) h.more[i - 1u].dout_line = (uint8_t)PIN_DOUT_MORE(i);
+    if (hx711_init(&h) != 0) { fprintf(stderr, "hx711: init failed\n"); return; }
+
+    // the first conversion after init was made with an unknown gain: dropped
+    int32_t first[HX711_MAX_CHANNELS];
+    if (hx711_read_raw(&h, first) != -3) fprintf(stderr, "%s: first conversion not discarded\n", label);
+
+    gpio_sim_stats_t st;
+    gpio_sim_get_stats(&st);
+    uint64_t ops0 = st.ops;
+    uint64_t io0 = h.io_calls;
+
+    uint32_t ok = 0, bad = 0;
+    uint64_t t0 = gpio_sim_now_ns();
+    double w0 = wall_s();
+    for (uint32_t i = 0; i < n_reads; i++) {
+        int32_t raw[HX711_MAX_CHANNELS];
+        if (hx711_read_raw(&h, raw) != 0) { bad++; continue; }
+        int same = 1;
+        for (unsigned c = 0; c < hx711_channels(&h); c++) same &= (raw[c] == cfg.hx_counts[(i + 1u) % cfg.hx_count_n]);
+        if (same) ok++;
+        else bad++;
+    }
+    double wall = wall_s() - w0;
+    double virt = (double)(gpio_sim_now_ns() - t0) * 1e-9;
+
+    gpio_sim_get_stats(&st);
+    printf("%s: reads=%lu ok=%lu bad=%lu virt=%.3f s wall=%.4f s speedup=%.0fx\n",
+           label, (unsigned long)n_reads, (unsigned long)ok, (unsigned long)bad, virt, wall,
+           wall > 0.0 ? virt / wall : 0.0);
+    printf("%s: samples_per_s virt=%.2f wall=%.0f gpio_calls_per_read=%.1f sim_ops_per_read=%.1f\n",
+           label, virt > 0.0 ? (double)ok / virt : 0.0, wall > 0.0 ? (double)n_reads / wall : 0.0,
+           (double)(h.io_calls - io0) / (double)n_reads, (double)(st.ops - ops0) / (double)n_reads);
+    printf("%s: ready_to_clock_us avg=%.1f read_window_us=%.1f sck_high_max_us=%.2f powerdowns=%llu\n",
+           label, (double)st.hx_ready_lat_ns * 1e-3 / (double)(st.hx_conversions ? st.hx_conversions : 1),
+           (double)st.hx_read_window_ns * 1e-3, (double)st.hx_sck_high_max_ns * 1e-3,
+           (unsigned long long)st.hx_sck_powerdowns);
+    printf("%s: pulses_per_read=%u rate_sps measured=%u period_us=%.1f\n",
+           label, (unsigned)st.hx_last_pulses, hx711_rate_sps(&h), (double)h.period_ns * 1e-3);
+
+    hx711_close(&h);
+}
+
+// Deposit pipeline at peak load on the virtual clock: the next item lands
+// land_ms after the last one was pushed off. serial = the old flow, where
+// the control loop sat out the whole stroke before looking at the scale.
+static double bench_deposit(uint32_t items, uint32_t land_ms, int serial){
+    gpio_sim_config_t cfg = sim_config();
+    gpio_sim_reset(&cfg);
+    const char *label = serial ? "deposit[serial]" : "deposit[pipelined]";
+
+    stepper_motor m = sim_motor();
+    if (stepper_init(&m) < 0 || stepper_enable(&m) < 0) { fprintf(stderr, "deposit: init failed\n"); return 0.0; }
+    uint32_t nx;
+    (void)stepper_update(&m, sim_now_us(), &nx);
+    m.enabled_at_us = 0;
+
+    deposit_cfg_t dc = {
+        .trig_kg = 0.015f,
+        .sample_count = 10u,
+        .settle = { .window = 8u, .band_kg = 0.002f, .slope_kg_s = 0.010f, .max_ms = 2000u },
+        .move_stp = -1333,
+        .speed_sps = 10000u,
+        .acc_sps2 = 10000u,
+        .quiet = 1,
+    };
+    deposit_t d;
+    deposit_init(&d, &dc, 0);
+
+    const uint64_t conv_ns = (uint64_t)cfg.hx_conv_period_us * 1000u;
+    uint64_t t0 = gpio_sim_now_ns(), next_conv = t0 + conv_ns, land_at = 0;
+    uint32_t seq = 0, posted = 0, push_seq = 0;
+    int on_scale = 1;
+
+    while (d.stats.items < items && gpio_sim_now_ns() - t0 < 600ull * 1000000000u) {
+        uint64_t now = gpio_sim_now_ns();
+        if (!on_scale && now >= land_at) on_scale = 1;
+        if (now >= next_conv) {
+            scale_sample_t s = { .kg = on_scale ? 0.100f : 0.0f, .t_ns = next_conv, .seq = ++seq };
+            if (!(serial && d.fly_n)) deposit_feed(&d, &m, &s, 0);
+            next_conv += conv_ns;
+        }
+        if (d.item != posted && !d.held && d.fly_n) {
+            posted = d.item;
+            push_seq = d.fly[(d.fly_head + d.fly_n - 1u) % DEPOSIT_INFLIGHT].out_seq;
+        }
+
+        uint32_t next_us;
+        int busy = stepper_update(&m, sim_now_us(), &next_us);
+        deposit_poll(&d, &m, gpio_sim_now_ns());
+        // the forward stroke pushes the item off
+        if (push_seq && stepper_seq_done(&m, push_seq)) {
+            push_seq = 0;
+            on_scale = 0;
+            land_at = gpio_sim_now_ns() + (uint64_t)land_ms * 1000000u;
+        }
+
+        uint64_t next = next_conv;
+        if (busy) {
+            uint64_t edge = gpio_sim_now_ns() + (uint64_t)(int64_t)(int32_t)(next_us - sim_now_us()) * 1000u;
+            if (edge < next) next = edge;
+        }
+        if (!on_scale && land_at < next) next = land_at;
+        if (next > gpio_sim_now_ns()) gpio_sim_advance_ns(next - gpio_sim_now_ns());
+    }
+
+    const deposit_stats_t *st = &d.stats;
+    uint64_t n = st->items ? st->items : 1u;
+    double rate = deposit_rate_per_min(&d);
+    printf("%s: items=%llu virt=%.1f s rate=%.1f items/min rearm_in_stroke=%llu\n", label,
+           (unsigned long long)st->items, (double)(gpio_sim_now_ns() - t0) * 1e-9, rate,
+           (unsigned long long)st->rearms_in_stroke);
+    printf("%s: avg ms settle=%llu weigh=%llu wait=%llu out=%llu back=%llu cycle=%llu\n", label,
+           (unsigned long long)(st->stage[DEP_STAGE_SETTLE].sum_ms / n),
+           (unsigned long long)(st->stage[DEP_STAGE_WEIGH].sum_ms / n),
+           (unsigned long long)(st->stage[DEP_STAGE_WAIT].sum_ms / n),
+           (unsigned long long)(st->stage[DEP_STAGE_OUT].sum_ms / n),
+           (unsigned long long)(st->stage[DEP_STAGE_BACK].sum_ms / n),
+           (unsigned long long)(st->stage[DEP_STAGE_CYCLE].sum_ms / n));
+    return rate;
+}
+
+// Zero tracking against a constant offset on an empty scale: the tare has
+// to reach it and then stay put. Returns 0 on pass.
+static int bench_zero_track(int32_t offset_cts, float rate_kg_s){
+    zero_track_cfg_t zc = {
+        .band_kg = 0.005f,
+        .rate_kg_s = rate_kg_s,
+        .hold_ms = 3000u,
+        .settle = { .window = 8u, .band_kg = 0.002f, .slope_kg_s = 0.010f, .max_ms = 2000u },
+    };
+    const int32_t tare = 1651769;
+    zero_track_t z;
+    zero_track_init(&z, &zc, tare, 951010.0f);
+
+    const uint64_t period_ns = 100000000u;          // 10 SPS
+    const uint32_t n = 6000u;                       // 10 min
+    uint32_t reached = 0, moves_after = 0;
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    for (uint32_t i = 1; i <= n; i++) {
+        int moved = zero_track_push(&z, tare + offset_cts, (uint64_t)i * period_ns);
+        int32_t t = zero_track_tare(&z);
+        if (!reached && t == tare + offset_cts) reached = i;
+        if (reached && i > reached) {
+            moves_after += (uint32_t)moved;
+            if (t < lo) lo = t;
+            if (t > hi) hi = t;
+        }
+    }
+    int ok = reached && moves_after == 0 && lo == tare + offset_cts && hi == lo;
+    printf("zero_track[%+ld cts @%g kg/s]: %s reached=%.1f s tare_after=%+ld..%+ld moves_after=%u\n",
+           (long)offset_cts, (double)rate_kg_s, ok ? "ok" : "FAIL",
+           (double)reached * (double)period_ns * 1e-9, (long)(lo - tare), (long)(hi - tare), moves_after);
+    return ok ? 0 : 1;
+}
+
+int main(void){
+    gpio_set_backend(&gpio_sim_backend);
+
+    bench_move(-1333, 10000u, 10000u);
+    bench_move(8000, 10000u, 10000u);
+    bench_move(200, 2000u, 8000u);
+    bench_stroke(-1333, 10000u, 10000u, 10000u);
+    bench_homing(2000u, 8000u);
+    bench_hx711(200u, 0, 1u, HX711_GAIN_A128, 10u);
+    bench_hx711(200u, 1, 1u, HX711_GAIN_A128, 10u);
+    bench_hx711(200u, 1, 4u, HX711_GAIN_A128, 10u);
+    bench_hx711(200u, 1, 1u, HX711_GAIN_A64, 80u);
+    double serial = bench_deposit(40u, 300u, 1);
+    double piped = bench_deposit(40u, 300u, 0);
+    printf("deposit: pipelined/serial throughput = %.2fx\n", serial > 0.0 ? piped / serial : 0.0);
+
+    int fail = 0;
+    fail |= bench_zero_track(5, 0.0001f);
+    fail |= bench_zero_track(-40, 0.0001f);
+    fail |= bench_zero_track(5, 0.000001f);
+    return fail;
+}
@@ -0,0 +1,234 @@
+#include "event_log.h"
+#include "notify.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_BUF_LEN  16384u
+#define LOG_LINE_MAX 256u
+
+static const char k_header[] =
+    "time, item, avg_kg, sd_kg, samples, settle_ms, weigh_ms, stroke_ms, cycle_ms\n";
+
+static struct {
+    event_log_cfg_t  cfg;
+    char             path[256];
+
+    // producer -> logger
+    event_log_item_t queue[EVENT_LOG_QUEUE_LEN];
+    _Atomic uint32_t q_head;
+    _Atomic uint32_t q_tail;
+    _Atomic uint32_t wake;      // futex word
+    _Atomic uint32_t dropped;
+    _Atomic int      stop;
+
+    // logger thread only
+    pthread_t        th;
+    int              started;
+    int              fd;
+    uint64_t         file_bytes;
+    int              file_yday, file_year;
+    char             buf[LOG_BUF_LEN];
+    size_t           buf_len;
+} g = { .fd = -1 };
+
+int event_log_parse_fsync(const char *s, uint32_t *out){
+    if (!s || !out) return -1;
+    if (strcmp(s, "never") == 0)  { *out = EVENT_LOG_FSYNC_NEVER;  return 0; }
+    if (strcmp(s, "rotate") == 0) { *out = EVENT_LOG_FSYNC_ROTATE; return 0; }
+    if (strcmp(s, "flush") == 0)  { *out = EVENT_LOG_FSYNC_FLUSH;  return 0; }
+    return -1;
+}
+
+// ---- producer side ----
+
+int event_log_item(const event_log_item_t *it){
+    if (!it || !g.started) return -2;
+
+    uint32_t head = atomic_load_explicit(&g.q_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&g.q_tail, memory_order_acquire);
+    if (head - tail >= EVENT_LOG_QUEUE_LEN) {
+        atomic_fetch_add_explicit(&g.dropped, 1u, memory_order_relaxed);
+        return -1;
+    }
+    g.queue[head & (EVENT_LOG_QUEUE_LEN - 1u)] = *it;
+    atomic_store_explicit(&g.q_head, head + 1u, memory_order_release);
+    notify_post(&g.wake);
+    return 0;
+}
+
+uint32_t event_log_dropped(void){
+    return atomic_load_explicit(&g.dropped, memory_order_relaxed);
+}
+
+// ---- logger thread ----
+
+static void write_all(const char *p, size_t n){
+    while (n > 0 && g.fd >= 0) {
+        ssize_t w = write(g.fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            perror("event_log write");
+            return;     // drop the rest of this batch, keep the thread alive
+        }
+        p += w;
+        n -= (size_t)w;
+        g.file_bytes += (uint64_t)w;
+    }
+}
+
+static void flush_buf(void){
+    if (g.buf_len == 0) return;
+    write_all(g.buf, g.buf_len);
+    g.buf_len = 0;
+    if (g.cfg.fsync == EVENT_LOG_FSYNC_FLUSH && g.fd >= 0) (void)fdatasync(g.fd);
+}
+
+static void append(const char *s, size_t n){
+    if (g.buf_len + n > sizeof(g.buf)) flush_buf();
+    memcpy(g.buf + g.buf_len, s, n);
+    g.buf_len += n;
+}
+
+static int open_file(void){
+    g.fd = open(g.path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (g.fd < 0) {
+        perror("event_log open");
+        return -1;
+    }
+    struct stat st;
+    g.file_bytes = (fstat(g.fd, &st) == 0) ? (uint64_t)st.st_size : 0u;
+
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    g.file_yday = tm.tm_yday;
+    g.file_year = tm.tm_year;
+
+    if (g.file_bytes == 0) append(k_header, sizeof(k_header) - 1u);
+    return 0;
+}
+
+static void close_file(void){
+    flush_buf();
+    if (g.fd < 0) return;
+    if (g.cfg.fsync != EVENT_LOG_FSYNC_NEVER) (void)fdatasync(g.fd);
+    close(g.fd);
+    g.fd = -1;
+}
+
+static void rotate(void){
+    close_file();
+
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    char to[sizeof(g.path) + 32];
+    snprintf(to, sizeof(to), "%s.%s", g.path, stamp);
+    if (rename(g.path, to) != 0) perror("event_log rotate");
+
+    (void)open_file();
+}
+
+static void maybe_rotate(const struct tm *tm){
+    int by_size = g.cfg.rotate_bytes && g.file_bytes + g.buf_len >= g.cfg.rotate_bytes;
+    int by_date = g.cfg.rotate_daily && (tm->tm_yday != g.file_yday || tm->tm_year != g.file_year);
+    if (by_size || by_date) rotate();
+}
+
+static void format_item(const event_log_item_t *it){
+    time_t sec = (time_t)(it->t_real_ns / 1000000000u);
+    unsigned ms = (unsigned)((it->t_real_ns / 1000000u) % 1000u);
+    struct tm tm;
+    localtime_r(&sec, &tm);
+    maybe_rotate(&tm);
+
+    char ts[32];
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    char line[LOG_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "%s.%03u, %u, %.4f, %.5f, %u, %u, %u, %u, %u\n",
+                     ts, ms, it->item, (double)it->avg_kg, (double)it->sd_kg, it->samples,
+                     it->settle_ms, it->weigh_ms, it->stroke_ms, it->cycle_ms);
+    if (n > 0) append(line, ((size_t)n < sizeof(line)) ? (size_t)n : sizeof(line) - 1u);
+}
+
+static int drain(void){
+    int any = 0;
+    for (;;) {
+        uint32_t tail = atomic_load_explicit(&g.q_tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&g.q_head, memory_order_acquire)) return any;
+        event_log_item_t it = g.queue[tail & (EVENT_LOG_QUEUE_LEN - 1u)];
+        atomic_store_explicit(&g.q_tail, tail + 1u, memory_order_release);
+        format_item(&it);
+        any = 1;
+    }
+}
+
+static void* event_log_thread_fn(void *p){
+    (void)p;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!atomic_load(&g.stop)) {
+        uint32_t seen = atomic_load(&g.wake);
+        (void)drain();
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec >= next.tv_nsec)) {
+            flush_buf();
+            uint64_t ns = (uint64_t)g.cfg.flush_ms * 1000000u;
+            next = now;
+            next.tv_sec += (time_t)(ns / 1000000000u);
+            next.tv_nsec += (long)(ns % 1000000000u);
+            if (next.tv_nsec >= 1000000000L) { next.tv_sec++; next.tv_nsec -= 1000000000L; }
+        }
+        (void)notify_wait(&g.wake, seen, &next);
+    }
+
+    (void)drain();
+    close_file();
+    return 0;
+}
+
+int event_log_start(const event_log_cfg_t *cfg){
+    if (!cfg || !cfg->path || g.started) return -1;
+
+    g.cfg = *cfg;
+    strncpy(g.path, cfg->path, sizeof(g.path) - 1);
+    g.path[sizeof(g.path) - 1] = '\0';
+    g.cfg.path = g.path;
+    if (g.cfg.flush_ms == 0) g.cfg.flush_ms = 1;
+
+    atomic_store(&g.q_head, 0u);
+    atomic_store(&g.q_tail, 0u);
+    atomic_store(&g.stop, 0);
+    g.buf_len = 0;
+
+    if (open_file() < 0) return -2;
+    if (pthread_create(&g.th, 0, event_log_thread_fn, 0) != 0) {
+        close_file();
+        return -3;
+    }
+    g.started = 1;
+    return 0;
+}
+
+void event_log_stop(void){
+    if (!g.started) return;
+    atomic_store(&g.stop, 1);
+    notify_post(&g.wake);
+    pthread_join(g.th, 0);
+    g.started = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+/*
+    Background CSV logger for deposit events.
+
+    The control loop fills a fixed-size record and pushes it into an SPSC
+    queue; formatting, write(), fsync() and rotation all happen on the logger
+    thread. Pushing never blocks: when the queue is full the record is
+    dropped and counted.
+
+    The file stays open. Buffered lines are written every flush_ms (or when
+    the buffer fills). The file is rotated to "<path>.<YYYYmmdd-HHMMSS>" when
+    it exceeds rotate_bytes or, with rotate_daily, when the local date changes.
+*/
+typedef enum {
+    EVENT_LOG_FSYNC_NEVER = 0,  // leave it to the kernel
+    EVENT_LOG_FSYNC_ROTATE,     // on rotation and close only
+    EVENT_LOG_FSYNC_FLUSH,      // after every flush
+} event_log_fsync_t;
+
+typedef struct event_log_cfg {
+    const char *path;
+    uint32_t flush_ms;
+    uint32_t fsync;             // event_log_fsync_t
+    uint64_t rotate_bytes;      // 0 = never
+    uint32_t rotate_daily;      // 0/1
+} event_log_cfg_t;
+
+typedef struct event_log_item {
+    uint64_t t_real_ns;         // CLOCK_REALTIME when the item was weighed
+    uint32_t item;              // running item number
+    float    avg_kg;
+    float    sd_kg;             // stddev of the settled window
+    uint32_t samples;
+    uint32_t settle_ms;         // trigger -> stable
+    uint32_t weigh_ms;          // stable -> average done
+    uint32_t stroke_ms;         // stroke queued -> back at 0
+    uint32_t cycle_ms;          // trigger -> back at 0
+} event_log_item_t;
+
+#define EVENT_LOG_QUEUE_LEN 64u  // power of two
+
+// Opens the file and starts the thread. Returns 0, or <0 on error.
+int      event_log_start(const event_log_cfg_t *cfg);
+// Flush, fsync (unless FSYNC_NEVER), close and join.
+void     event_log_stop(void);
+
+// Never blocks. Returns 0, -1 if the queue was full (record dropped), or
+// -2 if the logger is not running.
+int      event_log_item(const event_log_item_t *it);
+uint32_t event_log_dropped(void);
+
+// "never" | "rotate" | "flush" -> event_log_fsync_t. Returns 0 or -1.
+int      event_log_parse_fsync(const char *s, uint32_t *out);
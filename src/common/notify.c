@@ -0,0 +1,70 @@
+#include "notify.h"
+
+#include <errno.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
+
+void notify_deadline(struct timespec *out, uint32_t timeout_ms){
+    clock_gettime(CLOCK_MONOTONIC, out);
+    out->tv_sec  += (time_t)(timeout_ms / 1000u);
+    out->tv_nsec += (long)(timeout_ms % 1000u) * 1000000L;
+    if (out->tv_nsec >= 1000000000L) { out->tv_nsec -= 1000000000L; out->tv_sec++; }
+}
+
+int notify_wait(_Atomic uint32_t *word, uint32_t seen, const struct timespec *abs_deadline){
+    if (atomic_load_explicit(word, memory_order_acquire) != seen) return 0;
+#ifdef __linux__
+    // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline
+    long rc = syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+                      seen, abs_deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+    if (rc < 0 && errno == ETIMEDOUT) return -1;
+    return 0;
+#else
+    // portable fallback: poll every 1 ms
+    for (;;) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (abs_deadline && (now.tv_sec > abs_deadline->tv_sec ||
+            (now.tv_sec == abs_deadline->tv_sec && now.tv_nsec >= abs_deadline->tv_nsec))) return -1;
+        struct timespec ts = { .tv_sec = 0, .tv_nsec = 1000000L };
+        nanosleep(&ts, 0);
+        if (atomic_load_explicit(word, memory_order_acquire) != seen) return 0;
+    }
+#endif
+}
+
+static void wake_all(_Atomic uint32_t *word){
+#ifdef __linux__
+    (void)syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+void notify_post(_Atomic uint32_t *word){
+    atomic_fetch_add_explicit(word, 1u, memory_order_release);
+    wake_all(word);
+}
+
+// The store to *word and the load of *waiters here, and the increment of
+// *waiters and the load of *word in notify_wait_counted(), are ordered by
+// seq_cst: either the producer sees the waiter or the waiter sees the new
+// value (and the futex compare catches everything in between).
+void notify_wake_waiters(_Atomic uint32_t *word, _Atomic uint32_t *waiters){
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiters, memory_order_relaxed)) wake_all(word);
+}
+
+int notify_wait_counted(_Atomic uint32_t *word, _Atomic uint32_t *waiters, uint32_t seen,
+                        const struct timespec *abs_deadline){
+    atomic_fetch_add_explicit(waiters, 1u, memory_order_seq_cst);
+    int rc = 0;
+    if (atomic_load_explicit(word, memory_order_seq_cst) == seen) rc = notify_wait(word, seen, abs_deadline);
+    atomic_fetch_sub_explicit(waiters, 1u, memory_order_relaxed);
+    return rc;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+    Minimal wait/wake on a 32-bit counter (futex on Linux).
+
+    Producers bump the counter with notify_post(). Consumers read the
+    counter, check their condition, and then call notify_wait() with the value
+    they read, so a wake between the check and the wait is never lost.
+
+    A word published at sample rate can keep a waiter count next to it: the
+    producer then only makes the wake syscall when someone is waiting
+    (notify_wake_waiters()), and consumers wait with notify_wait_counted().
+*/
+
+// *out = CLOCK_MONOTONIC now + timeout_ms, for notify_wait().
+void notify_deadline(struct timespec *out, uint32_t timeout_ms);
+
+// Block while *word == seen, until abs_deadline (CLOCK_MONOTONIC) or forever if NULL.
+// Returns 0 when woken or the value already changed, -1 on timeout.
+int  notify_wait(_Atomic uint32_t *word, uint32_t seen, const struct timespec *abs_deadline);
+
+// Bump *word and wake every waiter.
+void notify_post(_Atomic uint32_t *word);
+
+// After the producer has changed *word: wake its waiters, if *waiters says
+// there are any.
+void notify_wake_waiters(_Atomic uint32_t *word, _Atomic uint32_t *waiters);
+
+// notify_wait(), registered in *waiters for the duration.
+int  notify_wait_counted(_Atomic uint32_t *word, _Atomic uint32_t *waiters, uint32_t seen,
+                         const struct timespec *abs_deadline);
@@ -0,0 +1,199 @@
+#include "scale_filter.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+static uint8_t clamp_len(uint8_t n, int odd){
+    if (n < 1u) n = 1u;
+    if (n > SCALE_FILTER_MAX_WIN) n = SCALE_FILTER_MAX_WIN;
+    if (odd && (n % 2u) == 0u) n--;
+    return n;
+}
+
+void scale_filter_cfg_defaults(scale_filter_cfg_t *c){
+    if (!c) return;
+    memset(c, 0, sizeof(*c));
+    c->median_len    = 5u;
+    c->mad_len       = 9u;
+    c->mad_k_q8      = (uint16_t)(3.5 * 256.0);
+    c->mad_min_cts   = 200;
+    c->ema_alpha_q16 = 19661u;          // 0.3
+    c->fir_len       = 5u;
+    const int16_t taps[5] = { 1, 2, 3, 2, 1 };
+    memcpy(c->fir_taps, taps, sizeof(taps));
+}
+
+int scale_filter_parse_chain(scale_filter_cfg_t *c, const char *s){
+    if (!c || !s) return -1;
+    memset(c->stages, 0, sizeof(c->stages));
+
+    unsigned n = 0;
+    while (*s) {
+        while (*s == ',' || isspace((unsigned char)*s)) s++;
+        if (!*s) break;
+        size_t len = 0;
+        while (s[len] && s[len] != ',' && !isspace((unsigned char)s[len])) len++;
+
+        uint8_t kind;
+        if      (len == 4 && strncmp(s, "none", 4) == 0)   kind = SF_NONE;
+        else if (len == 3 && strncmp(s, "mad", 3) == 0)    kind = SF_MAD;
+        else if (len == 6 && strncmp(s, "median", 6) == 0) kind = SF_MEDIAN;
+        else if (len == 3 && strncmp(s, "ema", 3) == 0)    kind = SF_EMA;
+        else if (len == 3 && strncmp(s, "fir", 3) == 0)    kind = SF_FIR;
+        else return -1;
+
+        if (kind != SF_NONE) {
+            if (n >= SCALE_FILTER_MAX_STAGES) return -1;
+            c->stages[n++] = kind;
+        }
+        s += len;
+    }
+    return 0;
+}
+
+int scale_filter_parse_taps(scale_filter_cfg_t *c, const char *s){
+    if (!c || !s) return -1;
+    int16_t taps[SCALE_FILTER_MAX_WIN];
+    uint8_t n = 0;
+    while (*s) {
+        char *end = NULL;
+        long v = strtol(s, &end, 0);
+        if (end == s || v < -32768 || v > 32767) return -1;
+        if (n >= SCALE_FILTER_MAX_WIN) return -1;
+        taps[n++] = (int16_t)v;
+        s = end;
+        while (*s == ',' || isspace((unsigned char)*s)) s++;
+    }
+    if (n == 0) return -1;
+    memcpy(c->fir_taps, taps, sizeof(taps[0]) * n);
+    c->fir_len = n;
+    return 0;
+}
+
+void scale_filter_init(scale_filter_t *f, const scale_filter_cfg_t *cfg){
+    if (!f || !cfg) return;
+    memset(f, 0, sizeof(*f));
+    f->cfg = *cfg;
+    f->cfg.median_len = clamp_len(f->cfg.median_len, 1);
+    f->cfg.mad_len    = clamp_len(f->cfg.mad_len, 1);
+    f->cfg.fir_len    = clamp_len(f->cfg.fir_len, 0);
+    if (f->cfg.ema_alpha_q16 == 0 || f->cfg.ema_alpha_q16 > 65536u) f->cfg.ema_alpha_q16 = 65536u;
+
+    for (uint8_t i = 0; i < f->cfg.fir_len; i++) f->fir_tap_sum += f->cfg.fir_taps[i];
+    if (f->fir_tap_sum == 0) {
+        // degenerate taps: fall back to a plain 1-tap pass-through
+        f->cfg.fir_len = 1;
+        f->cfg.fir_taps[0] = 1;
+        f->fir_tap_sum = 1;
+    }
+}
+
+// ---- helpers ----
+
+static void sort_small(int32_t *a, uint8_t n){
+    for (uint8_t i = 1; i < n; i++) {
+        int32_t v = a[i];
+        uint8_t j = i;
+        while (j > 0 && a[j - 1] > v) { a[j] = a[j - 1]; j--; }
+        a[j] = v;
+    }
+}
+
+static int32_t median_of(const int32_t *win, uint8_t n){
+    int32_t tmp[SCALE_FILTER_MAX_WIN];
+    memcpy(tmp, win, sizeof(tmp[0]) * n);
+    sort_small(tmp, n);
+    return tmp[n / 2u];
+}
+
+// Start every window full of the first sample, so there is no warm-up branch.
+static void prime(scale_filter_t *f, int32_t x){
+    for (uint8_t i = 0; i < SCALE_FILTER_MAX_WIN; i++) {
+        f->mad_win[i] = x;
+        f->med_win[i] = x;
+        f->med_sorted[i] = x;
+        f->fir_win[i] = x;
+    }
+    f->ema_q16 = (int64_t)x * 65536;
+    f->primed = 1;
+}
+
+// ---- stages ----
+
+static int stage_mad(scale_filter_t *f, int32_t x){
+    uint8_t n = f->cfg.mad_len;
+    f->mad_win[f->mad_pos] = x;
+    f->mad_pos = (uint8_t)((f->mad_pos + 1u) % n);
+
+    int32_t med = median_of(f->mad_win, n);
+    int32_t dev[SCALE_FILTER_MAX_WIN];
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t d = f->mad_win[i] - med;
+        dev[i] = (d < 0) ? -d : d;
+    }
+    int32_t mad = median_of(dev, n);
+    if (mad < f->cfg.mad_min_cts) mad = f->cfg.mad_min_cts;
+
+    // |x - med| > k * 1.4826 * MAD; 1.4826 ~= 380/256
+    int64_t lim = ((int64_t)mad * 380 / 256) * f->cfg.mad_k_q8 / 256;
+    int64_t d = (int64_t)x - med;
+    if (d < 0) d = -d;
+    return d <= lim;
+}
+
+static int32_t stage_median(scale_filter_t *f, int32_t x){
+    uint8_t n = f->cfg.median_len;
+    int32_t old = f->med_win[f->med_pos];
+    f->med_win[f->med_pos] = x;
+    f->med_pos = (uint8_t)((f->med_pos + 1u) % n);
+
+    // drop the oldest value from the sorted copy, then insert the new one
+    uint8_t i = 0;
+    while (i < n - 1u && f->med_sorted[i] != old) i++;
+    for (; i < n - 1u; i++) f->med_sorted[i] = f->med_sorted[i + 1u];
+    i = (uint8_t)(n - 1u);
+    while (i > 0 && f->med_sorted[i - 1u] > x) { f->med_sorted[i] = f->med_sorted[i - 1u]; i--; }
+    f->med_sorted[i] = x;
+
+    return f->med_sorted[n / 2u];
+}
+
+static int32_t stage_ema(scale_filter_t *f, int32_t x){
+    int64_t xq = (int64_t)x * 65536;
+    f->ema_q16 += ((xq - f->ema_q16) * (int64_t)f->cfg.ema_alpha_q16) / 65536;
+    return (int32_t)((f->ema_q16 + 32768) / 65536);
+}
+
+static int32_t stage_fir(scale_filter_t *f, int32_t x){
+    uint8_t n = f->cfg.fir_len;
+    f->fir_win[f->fir_pos] = x;
+    int64_t acc = 0;
+    uint8_t j = f->fir_pos;
+    for (uint8_t i = 0; i < n; i++) {
+        acc += (int64_t)f->cfg.fir_taps[i] * f->fir_win[j];
+        j = (uint8_t)((j == 0) ? n - 1u : j - 1u);
+    }
+    f->fir_pos = (uint8_t)((f->fir_pos + 1u) % n);
+    return (int32_t)(acc / f->fir_tap_sum);
+}
+
+int scale_filter_process(scale_filter_t *f, int32_t raw, int32_t *out){
+    if (!f || !out) return 0;
+    if (!f->primed) prime(f, raw);
+
+    int32_t x = raw;
+    for (unsigned s = 0; s < SCALE_FILTER_MAX_STAGES; s++) {
+        switch (f->cfg.stages[s]) {
+        case SF_MAD:
+            if (!stage_mad(f, x)) { f->rejected++; return 0; }
+            break;
+        case SF_MEDIAN: x = stage_median(f, x); break;
+        case SF_EMA:    x = stage_ema(f, x);    break;
+        case SF_FIR:    x = stage_fir(f, x);    break;
+        default:        s = SCALE_FILTER_MAX_STAGES; break;
+        }
+    }
+    *out = x;
+    return 1;
+}
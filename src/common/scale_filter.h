@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+/*
+    Filter chain for raw HX711 counts, run on every conversion before it is
+    published. Integer / fixed point only, no allocation. Stages run in the
+    configured order:
+
+      mad     outlier rejection: drop x if |x - median| > k * 1.4826 * MAD
+              over the last mad_len raw samples (rejected samples still enter
+              the window, so a real step in weight is accepted after
+              mad_len/2 conversions)
+      median  running median over median_len samples (odd)
+      ema     y += alpha * (x - y), alpha in Q16
+      fir     sum(taps[i] * x[n-i]) / sum(taps)
+*/
+typedef enum {
+    SF_NONE = 0,
+    SF_MAD,
+    SF_MEDIAN,
+    SF_EMA,
+    SF_FIR,
+} scale_filter_kind_t;
+
+#define SCALE_FILTER_MAX_STAGES 4u
+#define SCALE_FILTER_MAX_WIN    15u
+
+typedef struct scale_filter_cfg {
+    uint8_t  stages[SCALE_FILTER_MAX_STAGES];   // scale_filter_kind_t, SF_NONE terminates
+    uint8_t  median_len;
+    uint8_t  mad_len;
+    uint16_t mad_k_q8;          // threshold in MADs, Q8
+    int32_t  mad_min_cts;       // MAD floor, so a quiet scale does not reject its own noise
+    uint32_t ema_alpha_q16;     // 1..65536
+    uint8_t  fir_len;
+    int16_t  fir_taps[SCALE_FILTER_MAX_WIN];
+} scale_filter_cfg_t;
+
+typedef struct scale_filter {
+    scale_filter_cfg_t cfg;
+    uint8_t  primed;
+
+    int32_t  mad_win[SCALE_FILTER_MAX_WIN];
+    uint8_t  mad_pos;
+
+    int32_t  med_win[SCALE_FILTER_MAX_WIN];     // arrival order
+    int32_t  med_sorted[SCALE_FILTER_MAX_WIN];
+    uint8_t  med_pos;
+
+    int64_t  ema_q16;
+
+    int32_t  fir_win[SCALE_FILTER_MAX_WIN];
+    uint8_t  fir_pos;
+    int32_t  fir_tap_sum;
+
+    uint32_t rejected;          // samples dropped by the mad stage
+} scale_filter_t;
+
+// Defaults: empty chain (pass-through) with sane per-stage parameters.
+void scale_filter_cfg_defaults(scale_filter_cfg_t *cfg);
+
+// Parse "mad,median,ema" (or "none") into cfg->stages. Returns 0 or -1.
+int  scale_filter_parse_chain(scale_filter_cfg_t *cfg, const char *s);
+// Parse "1,2,3,2,1" into cfg->fir_taps / fir_len. Returns 0 or -1.
+int  scale_filter_parse_taps(scale_filter_cfg_t *cfg, const char *s);
+
+void scale_filter_init(scale_filter_t *f, const scale_filter_cfg_t *cfg);
+
+// Run one raw sample through the chain. Returns 1 and sets *out, or 0 if
+// the sample was rejected.
+int  scale_filter_process(scale_filter_t *f, int32_t raw, int32_t *out);
@@ -0,0 +1,80 @@
+#include "scale_ring.h"
+#include "notify.h"
+
+#include <string.h>
+
+#define RING_MASK   (SCALE_RING_LEN - 1u)
+
+void scale_ring_push(scale_ring_t *r, int32_t raw, float kg, uint64_t t_ns){
+    // seq 0 (once per 2^32 records) is dropped by readers like a torn slot
+    uint32_t seq = atomic_load_explicit(&r->head_seq, memory_order_relaxed) + 1u;
+    scale_ring_slot_t *sl = &r->slot[seq & RING_MASK];
+    uint32_t bits;
+    memcpy(&bits, &kg, sizeof(bits));
+
+    atomic_store_explicit(&sl->stamp, 0u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&sl->raw, (uint32_t)raw, memory_order_relaxed);
+    atomic_store_explicit(&sl->kg_bits, bits, memory_order_relaxed);
+    atomic_store_explicit(&sl->t_lo, (uint32_t)t_ns, memory_order_relaxed);
+    atomic_store_explicit(&sl->t_hi, (uint32_t)(t_ns >> 32), memory_order_relaxed);
+
+    atomic_store_explicit(&sl->stamp, seq, memory_order_release);
+    atomic_store_explicit(&r->head_seq, seq, memory_order_release);
+    notify_wake_waiters(&r->head_seq, &r->waiters);
+}
+
+uint32_t scale_ring_seq(const scale_ring_t *r){
+    return atomic_load_explicit(&r->head_seq, memory_order_acquire);
+}
+
+static int read_slot(const scale_ring_t *r, uint32_t seq, scale_sample_t *out){
+    const scale_ring_slot_t *sl = &r->slot[seq & RING_MASK];
+    if (atomic_load_explicit(&sl->stamp, memory_order_acquire) != seq) return 0;
+    uint32_t raw  = atomic_load_explicit(&sl->raw, memory_order_relaxed);
+    uint32_t bits = atomic_load_explicit(&sl->kg_bits, memory_order_relaxed);
+    uint32_t lo   = atomic_load_explicit(&sl->t_lo, memory_order_relaxed);
+    uint32_t hi   = atomic_load_explicit(&sl->t_hi, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&sl->stamp, memory_order_relaxed) != seq) return 0;
+
+    out->raw = (int32_t)raw;
+    memcpy(&out->kg, &bits, sizeof(out->kg));
+    out->t_ns = (uint64_t)hi << 32 | lo;
+    out->seq = seq;
+    return 1;
+}
+
+size_t scale_ring_since(const scale_ring_t *r, uint32_t seq, scale_sample_t *out, size_t max){
+    if (!r || !out || max == 0) return 0;
+    uint32_t head = scale_ring_seq(r);
+    uint32_t avail = head - seq;
+    if ((int32_t)avail <= 0) return 0;
+    if (avail > SCALE_RING_LEN) avail = SCALE_RING_LEN;
+
+    // oldest first, so a caller can page through with the last seq it got
+    size_t n = 0;
+    for (uint32_t s = head - avail + 1u; (int32_t)(head - s) >= 0 && n < max; s++) {
+        if (s == 0) continue;
+        if (read_slot(r, s, &out[n])) n++;
+    }
+    return n;
+}
+
+size_t scale_ring_last(const scale_ring_t *r, scale_sample_t *out, size_t n){
+    if (!r) return 0;
+    if (n > SCALE_RING_LEN) n = SCALE_RING_LEN;
+    return scale_ring_since(r, scale_ring_seq(r) - (uint32_t)n, out, n);
+}
+
+int scale_ring_wait(scale_ring_t *r, uint32_t seq, uint32_t timeout_ms){
+    struct timespec deadline;
+    notify_deadline(&deadline, timeout_ms);
+
+    for (;;) {
+        uint32_t head = scale_ring_seq(r);
+        if (head != seq) return 0;
+        if (notify_wait_counted(&r->head_seq, &r->waiters, head, &deadline) < 0) return -1;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Lock-free ring of scale conversions: one producer (the HX711 thread),
+    any number of readers. Every conversion gets its own record, so readers
+    never see the same reading twice.
+
+    Each slot is stamped with the sequence number of the record it holds;
+    the writer clears the stamp while it fills the slot, so a reader that
+    races the writer sees a stamp mismatch and drops that record instead of
+    returning a torn one. As in scale_state_t, the slot fields are 32-bit
+    atomics, so the racing copy itself is not a data race either.
+*/
+typedef struct scale_sample {
+    int32_t  raw;
+    float    kg;
+    uint64_t t_ns;              // CLOCK_MONOTONIC time the conversion was ready
+    uint32_t seq;               // 1, 2, 3, ... (0 = none)
+} scale_sample_t;
+
+#define SCALE_RING_LEN  256u    // power of two
+
+typedef struct scale_ring_slot {
+    _Atomic uint32_t stamp;     // seq of the record held, 0 while it is written
+    _Atomic uint32_t raw;
+    _Atomic uint32_t kg_bits;
+    _Atomic uint32_t t_lo, t_hi;
+} scale_ring_slot_t;
+
+typedef struct scale_ring {
+    scale_ring_slot_t slot[SCALE_RING_LEN];
+    _Atomic uint32_t head_seq;  // newest published seq; also the futex word for waiters
+    _Atomic uint32_t waiters;   // threads in scale_ring_wait(); no wake syscall while 0
+} scale_ring_t;
+
+// producer only
+void     scale_ring_push(scale_ring_t *r, int32_t raw, float kg, uint64_t t_ns);
+
+// seq of the newest record, 0 if empty
+uint32_t scale_ring_seq(const scale_ring_t *r);
+
+// Copy up to n of the newest records, oldest first. Returns the number copied.
+size_t   scale_ring_last(const scale_ring_t *r, scale_sample_t *out, size_t n);
+
+// Copy records newer than seq, oldest first, at most max. Records that were
+// already overwritten are skipped. Returns the number copied.
+size_t   scale_ring_since(const scale_ring_t *r, uint32_t seq, scale_sample_t *out, size_t max);
+
+// Block until a record newer than seq exists. 0 = ready, -1 = timeout.
+int      scale_ring_wait(scale_ring_t *r, uint32_t seq, uint32_t timeout_ms);
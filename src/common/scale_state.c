@@ -0,0 +1,74 @@
+#include "scale_state.h"
+#include "notify.h"
+
+#include <string.h>
+
+static void write_begin(scale_state_t *s){
+    uint32_t gen = atomic_load_explicit(&s->gen, memory_order_relaxed);
+    atomic_store_explicit(&s->gen, gen + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void write_end(scale_state_t *s){
+    uint32_t gen = atomic_load_explicit(&s->gen, memory_order_relaxed);
+    atomic_store_explicit(&s->gen, gen + 1u, memory_order_release);
+}
+
+void scale_state_publish(scale_state_t *s, int32_t raw, float kg, uint64_t t_ns){
+    uint32_t bits;
+    memcpy(&bits, &kg, sizeof(bits));
+    uint32_t seq = atomic_load_explicit(&s->seq, memory_order_relaxed) + 1u;
+
+    write_begin(s);
+    atomic_store_explicit(&s->raw, (uint32_t)raw, memory_order_relaxed);
+    atomic_store_explicit(&s->kg_bits, bits, memory_order_relaxed);
+    atomic_store_explicit(&s->t_lo, (uint32_t)t_ns, memory_order_relaxed);
+    atomic_store_explicit(&s->t_hi, (uint32_t)(t_ns >> 32), memory_order_relaxed);
+    atomic_store_explicit(&s->status, SCALE_OK, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, seq, memory_order_relaxed);
+    write_end(s);
+
+    notify_wake_waiters(&s->seq, &s->waiters);
+}
+
+void scale_state_set_status(scale_state_t *s, scale_status_t status){
+    if (atomic_load_explicit(&s->status, memory_order_relaxed) == (uint32_t)status) return;
+    write_begin(s);
+    atomic_store_explicit(&s->status, (uint32_t)status, memory_order_relaxed);
+    write_end(s);
+}
+
+void scale_state_get(const scale_state_t *s, scale_snapshot_t *out){
+    uint32_t g0, g1, raw, bits, lo, hi, status, seq;
+    do {
+        g0 = atomic_load_explicit(&s->gen, memory_order_acquire);
+        raw    = atomic_load_explicit(&s->raw, memory_order_relaxed);
+        bits   = atomic_load_explicit(&s->kg_bits, memory_order_relaxed);
+        lo     = atomic_load_explicit(&s->t_lo, memory_order_relaxed);
+        hi     = atomic_load_explicit(&s->t_hi, memory_order_relaxed);
+        status = atomic_load_explicit(&s->status, memory_order_relaxed);
+        seq    = atomic_load_explicit(&s->seq, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        g1 = atomic_load_explicit(&s->gen, memory_order_relaxed);
+    } while ((g0 & 1u) || g0 != g1);
+
+    out->raw = (int32_t)raw;
+    memcpy(&out->kg, &bits, sizeof(out->kg));
+    out->t_ns = (uint64_t)hi << 32 | lo;
+    out->seq = seq;
+    out->status = (uint8_t)status;
+}
+
+int scale_state_wait(scale_state_t *s, uint32_t seq, uint32_t timeout_ms, scale_snapshot_t *out){
+    struct timespec deadline;
+    notify_deadline(&deadline, timeout_ms);
+
+    int rc = 0;
+    for (;;) {
+        uint32_t cur = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (cur != seq) break;
+        if (notify_wait_counted(&s->seq, &s->waiters, cur, &deadline) < 0) { rc = -1; break; }
+    }
+    scale_state_get(s, out);
+    return rc;
+}
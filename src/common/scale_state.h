@@ -0,0 +1,47 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+    Latest conversion of one scale channel as a single snapshot: raw counts,
+    kg, ready time, sequence number and status always come from the same
+    conversion. One writer (the HX711 thread), any number of readers.
+
+    Seqlock: the writer makes gen odd while it stores, readers retry until
+    they see the same even gen on both sides. Every field is a 32-bit
+    atomic, so reads stay lock-free on any target without libatomic.
+*/
+typedef enum {
+    SCALE_NONE = 0,             // nothing published yet
+    SCALE_OK,
+    SCALE_TIMEOUT,              // no conversion within the driver timeout: values are the last good ones
+} scale_status_t;
+
+typedef struct scale_snapshot {
+    int32_t  raw;               // filtered counts
+    float    kg;
+    uint64_t t_ns;              // CLOCK_MONOTONIC time the conversion was ready
+    uint32_t seq;               // conversions published, 0 = none
+    uint8_t  status;            // scale_status_t
+} scale_snapshot_t;
+
+typedef struct scale_state {
+    _Atomic uint32_t gen;
+    _Atomic uint32_t raw;
+    _Atomic uint32_t kg_bits;
+    _Atomic uint32_t t_lo, t_hi;
+    _Atomic uint32_t status;
+    _Atomic uint32_t seq;       // also the futex word for scale_state_wait()
+    _Atomic uint32_t waiters;
+} scale_state_t;
+
+// writer only
+void scale_state_publish(scale_state_t *s, int32_t raw, float kg, uint64_t t_ns);
+void scale_state_set_status(scale_state_t *s, scale_status_t status);
+
+// Never blocks and never sees a mix of two conversions.
+void scale_state_get(const scale_state_t *s, scale_snapshot_t *out);
+
+// Block until a conversion newer than seq is published, then snapshot it.
+// 0 = ready, -1 = timeout (*out still holds the current snapshot).
+int  scale_state_wait(scale_state_t *s, uint32_t seq, uint32_t timeout_ms, scale_snapshot_t *out);
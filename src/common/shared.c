@@ -1,3 +1,4 @@
 #include "shared.h"
-_Atomic float g_scale_kg = 0.0f;
-_Atomic int scale_raw_value = 0;
\ No newline at end of file
+scale_state_t g_scale_state;
+scale_ring_t g_scale_ring;
+scale_ring_t g_scale_ring_more[SCALE_MAX_CHANNELS - 1u];
@@ -1,5 +1,15 @@
 #pragma once
 #include <stdatomic.h>
+#include "scale_ring.h"
+#include "scale_state.h"
 
-extern _Atomic float g_scale_kg;
-extern _Atomic int scale_raw_value;
\ No newline at end of file
+#define SCALE_MAX_CHANNELS 8u
+
+extern scale_state_t g_scale_state;     // channel 0: newest accepted conversion
+extern scale_ring_t g_scale_ring;       // channel 0: the deposit trigger
+extern scale_ring_t g_scale_ring_more[SCALE_MAX_CHANNELS - 1u];
+
+// Conversions of one HX711 channel (0 = g_scale_ring).
+static inline scale_ring_t *scale_channel_ring(unsigned ch){
+    return ch ? &g_scale_ring_more[(ch - 1u) % (SCALE_MAX_CHANNELS - 1u)] : &g_scale_ring;
+}
@@ -0,0 +1,107 @@
+#include "telemetry.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static struct {
+    tlm_header_t *hdr;          // NULL while closed
+    tlm_rec_t    *rec;
+    uint32_t      mask;
+    size_t        map_len;
+} g;
+
+static uint32_t round_pow2(uint32_t v){
+    uint32_t p = 1u;
+    while (p < v && p < (1u << 30)) p <<= 1;
+    return p;
+}
+
+int telemetry_open(const char *path, uint32_t records){
+    if (!path || !path[0] || g.hdr) return -1;
+    uint32_t cap = round_pow2(records ? records : 1u);
+    size_t len = sizeof(tlm_header_t) + (size_t)cap * sizeof(tlm_rec_t);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("telemetry open");
+        return -2;
+    }
+
+    struct stat st;
+    int reuse = 0;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == len) {
+        tlm_header_t h;
+        if (pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && h.magic == TLM_MAGIC &&
+            h.version == TLM_VERSION && h.rec_size == sizeof(tlm_rec_t) && h.capacity == cap) {
+            reuse = 1;
+        }
+    }
+    // preallocate so a full SD card shows up here rather than as SIGBUS later
+    if (!reuse && (ftruncate(fd, 0) != 0 || posix_fallocate(fd, 0, (off_t)len) != 0)) {
+        perror("telemetry allocate");
+        close(fd);
+        return -3;
+    }
+
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("telemetry mmap");
+        return -4;
+    }
+
+    tlm_header_t *h = (tlm_header_t*)p;
+    if (!reuse) {
+        h->magic = TLM_MAGIC;
+        h->version = TLM_VERSION;
+        h->rec_size = (uint32_t)sizeof(tlm_rec_t);
+        h->capacity = cap;
+        atomic_store(&h->head, 0u);
+    }
+
+    g.rec = (tlm_rec_t*)((char*)p + sizeof(tlm_header_t));
+    g.mask = cap - 1u;
+    g.map_len = len;
+    g.hdr = h;
+    return 0;
+}
+
+void telemetry_close(void){
+    if (!g.hdr) return;
+    void *p = g.hdr;
+    g.hdr = NULL;
+    // Stop recording and push the pages out. The mapping itself stays until
+    // exit: the sampling threads are not joined and may be mid-record.
+    (void)msync(p, g.map_len, MS_SYNC);
+}
+
+static void put(uint8_t kind, uint8_t unit, uint8_t state, int32_t a, int32_t b, float f, uint64_t t_ns){
+    tlm_header_t *h = g.hdr;
+    if (!h) return;
+
+    uint64_t n = atomic_fetch_add_explicit(&h->head, 1u, memory_order_relaxed);
+    tlm_rec_t *r = &g.rec[n & g.mask];
+    atomic_store_explicit(&r->seq, 0u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    r->t_ns = t_ns;
+    r->kind = kind;
+    r->state = state;
+    r->unit = unit;
+    r->a = a;
+    r->b = b;
+    r->f = f;
+    atomic_store_explicit(&r->seq, n + 1u, memory_order_release);
+}
+
+void telemetry_hx711(uint8_t ch, int32_t raw, int32_t filtered, float kg, uint64_t t_ns){
+    put(TLM_REC_HX711, ch, 0u, raw, filtered, kg, t_ns);
+}
+
+void telemetry_stepper(uint8_t axis, uint8_t state, int32_t pos_stp, uint32_t speed_sps, uint64_t t_ns){
+    put(TLM_REC_STEPPER, axis, state, pos_stp, (int32_t)speed_sps, 0.0f, t_ns);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+    Always-on binary recorder. Fixed 32-byte records go into a ring that
+    lives in a preallocated, memory-mapped file, so a record costs one
+    fetch_add and a few stores; the kernel writes the pages back on its own
+    schedule and the data survives a crash of the process.
+
+    Any thread may record. A writer reserves a slot with fetch_add on head,
+    fills it and stores the record's seq last (release); a reader treats a
+    slot whose seq does not match its position as not yet written.
+
+    Decode offline with bin/tlm_decode (make tools).
+*/
+#define TLM_MAGIC   0x4d4c5457u     // "WTLM"
+#define TLM_VERSION 1u
+
+typedef enum {
+    TLM_REC_HX711   = 1,    // a = raw counts, b = filtered counts, f = kg (rejected: b = TLM_REJECTED, f = 0)
+    TLM_REC_STEPPER = 2,    // state, a = cur_pos_stp, b = peak steps/s of the segment (0 entering it)
+} tlm_rec_kind_t;
+
+#define TLM_REJECTED INT32_MIN
+
+typedef struct tlm_rec {
+    _Atomic uint64_t seq;   // 1, 2, 3 ... ; 0 = empty
+    uint64_t t_ns;          // CLOCK_MONOTONIC
+    uint8_t  kind;          // tlm_rec_kind_t
+    uint8_t  state;         // stepper_state_t for TLM_REC_STEPPER
+    uint8_t  unit;          // stepper axis / HX711 channel (0 in older files)
+    uint8_t  _pad;
+    int32_t  a;
+    int32_t  b;
+    float    f;
+} tlm_rec_t;
+
+typedef struct tlm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rec_size;
+    uint32_t capacity;      // records, power of two
+    _Atomic uint64_t head;  // records ever reserved
+    uint8_t  _pad[40];      // header is 64 bytes
+} tlm_header_t;
+
+_Static_assert(sizeof(tlm_rec_t) == 32, "tlm_rec_t must stay 32 bytes");
+_Static_assert(sizeof(tlm_header_t) == 64, "tlm_header_t must stay 64 bytes");
+
+// Map (creating or resizing as needed) a ring of `records` (rounded up to a
+// power of two). An existing file with the same geometry is appended to.
+// Returns 0, or <0 on error (recording stays off).
+int  telemetry_open(const char *path, uint32_t records);
+// Stop recording and sync the file.
+void telemetry_close(void);
+
+// No-ops while no file is open.
+void telemetry_hx711(uint8_t ch, int32_t raw, int32_t filtered, float kg, uint64_t t_ns);
+void telemetry_stepper(uint8_t axis, uint8_t state, int32_t pos_stp, uint32_t speed_sps, uint64_t t_ns);
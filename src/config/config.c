@@ -1,4 +1,5 @@
 #include "config.h"
+#include "event_log.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -30,11 +31,21 @@ void config_set_defaults(app_config_t *c){
     // HX711 calibration defaults
     c->hx_tare_offset_cts = 1748000;
     c->hx_counts_per_kg   = 951010.0f;
+    c->hx_channels        = 1u;
+    c->hx_gain            = HX711_GAIN_A128;
+    c->hx_rate_sps        = 10u;
+    c->gpio_mmio_path[0]  = '\0';
+    for (unsigned i = 0; i < HX711_MAX_CHANNELS - 1u; i++) {
+        c->hx_more[i].dout_line       = 0u;
+        c->hx_more[i].tare_offset_cts = 0;
+        c->hx_more[i].counts_per_kg   = 951010.0f;
+    }
 
     // Move defaults
     c->move_stp = 2000;
     c->move_speed_sps = 10000u;
     c->move_acc_sps2  = 10000u;
+    c->move_dwell_ms  = 0u;
 
     // Homing defaults
     c->home_offset_steps = 0;     // set to your sensor offset in steps
@@ -46,13 +57,41 @@ void config_set_defaults(app_config_t *c){
     c->trig_treshold = 0.030f;
 
     // Sampling defaults
-    c->settle_ms        = 1000u;
+    c->settle_window     = 8u;
+    c->settle_band_kg    = 0.002f;
+    c->settle_slope_kg_s = 0.010f;
+    c->settle_max_ms     = 2000u;
     c->sample_count     = 20u;
     c->sample_period_ms = 50u;
 
+    // Startup defaults
+    c->startup_warmup_ms       = 500u;
+    c->startup_tare            = 1u;
+    c->startup_tare_max_kg     = 0.050f;
+    c->startup_tare_timeout_ms = 10000u;
+
+    // Zero tracking defaults: off
+    c->zero_track     = 0u;
+    c->zero_band_kg   = 0.005f;
+    c->zero_rate_kg_s = 0.0001f;
+    c->zero_hold_ms   = 3000u;
+    c->zero_persist_s = 600u;
+    c->zero_state_path[0] = '\0';
+
+    // Filter defaults: pass-through
+    scale_filter_cfg_defaults(&c->filter);
+
     // CSV default path
     strncpy(c->csv_path, "/home/pi5/dev/Wingo_deposit_machine/scale_log.csv", sizeof(c->csv_path)-1);
     c->csv_path[sizeof(c->csv_path)-1] = '\0';
+    c->log_flush_ms     = 1000u;
+    c->log_fsync        = EVENT_LOG_FSYNC_ROTATE;
+    c->log_rotate_kb    = 0u;
+    c->log_rotate_daily = 0u;
+
+    // Telemetry defaults: off
+    c->tlm_path[0] = '\0';
+    c->tlm_records = 262144u;
 }
 
 static int parse_u32(const char *s, uint32_t *out){
@@ -85,15 +124,55 @@ static int parse_f32(const char *s, float *out){
     return 0;
 }
 
+static int parse_u8(const char *s, uint8_t *out){
+    uint32_t v;
+    if (parse_u32(s, &v) != 0 || v > 255u) return -1;
+    *out = (uint8_t)v;
+    return 0;
+}
+
+// "0.3" -> Q16, clamped to (0, 1]
+static int parse_alpha_q16(const char *s, uint32_t *out){
+    float v;
+    if (parse_f32(s, &v) != 0 || !(v > 0.0f) || v > 1.0f) return -1;
+    *out = (uint32_t)(v * 65536.0f + 0.5f);
+    if (*out == 0u) *out = 1u;
+    return 0;
+}
+
+static int parse_q8_u16(const char *s, uint16_t *out){
+    float v;
+    if (parse_f32(s, &v) != 0 || v < 0.0f || v > 255.0f) return -1;
+    *out = (uint16_t)(v * 256.0f + 0.5f);
+    return 0;
+}
+
 static int apply_kv(app_config_t *c, const char *k, const char *v){
     // HX711 calibration
     if (streq(k, "hx.tare_offset_cts")) return parse_i32(v, &c->hx_tare_offset_cts);
     if (streq(k, "hx.counts_per_kg"))   return parse_f32(v, &c->hx_counts_per_kg);
+    if (streq(k, "gpio.mmio_path")) {
+        strncpy(c->gpio_mmio_path, v, sizeof(c->gpio_mmio_path)-1);
+        c->gpio_mmio_path[sizeof(c->gpio_mmio_path)-1] = '\0';
+        return 0;
+    }
+    if (streq(k, "hx.channels"))        return parse_u32(v, &c->hx_channels);
+    if (streq(k, "hx.gain"))            return hx711_parse_gain(v, &c->hx_gain);
+    if (streq(k, "hx.rate_sps"))        return parse_u32(v, &c->hx_rate_sps);
+    if (strncmp(k, "hx.", 3) == 0 && k[3] >= '1' && k[3] < (char)('0' + HX711_MAX_CHANNELS) && k[4] == '.') {
+        unsigned i = (unsigned)(k[3] - '1');
+        const char *f = k + 5;
+        if (streq(f, "dout_line"))       return parse_u32(v, &c->hx_more[i].dout_line);
+        if (streq(f, "tare_offset_cts")) return parse_i32(v, &c->hx_more[i].tare_offset_cts);
+        if (streq(f, "counts_per_kg"))   return parse_f32(v, &c->hx_more[i].counts_per_kg);
+        return 0;
+    }
 
     // Move
     if (streq(k, "move.stp"))  return parse_i32(v, &c->move_stp);
     if (streq(k, "move.speed_sps")) return parse_u32(v, &c->move_speed_sps);
     if (streq(k, "move.acc_sps2"))  return parse_u32(v, &c->move_acc_sps2);
+    if (streq(k, "move.dwell_ms"))  return parse_u32(v, &c->move_dwell_ms);
 
     // Homing
     if (streq(k, "home.offset_steps")) return parse_i32(v, &c->home_offset_steps);
@@ -105,16 +184,58 @@ static int apply_kv(app_config_t *c, const char *k, const char *v){
     if (streq(k, "trigger.treshold"))   return parse_f32(v, &c->trig_treshold);
 
     // Sampling
-    if (streq(k, "sample.settle_ms"))   return parse_u32(v, &c->settle_ms);
+    if (streq(k, "settle.window"))      return parse_u32(v, &c->settle_window);
+    if (streq(k, "settle.band_kg"))     return parse_f32(v, &c->settle_band_kg);
+    if (streq(k, "settle.slope_kg_s"))  return parse_f32(v, &c->settle_slope_kg_s);
+    if (streq(k, "settle.max_ms"))      return parse_u32(v, &c->settle_max_ms);
     if (streq(k, "sample.count"))       return parse_u32(v, &c->sample_count);
     if (streq(k, "sample.period_ms"))   return parse_u32(v, &c->sample_period_ms);
 
+    // Startup
+    if (streq(k, "startup.warmup_ms"))       return parse_u32(v, &c->startup_warmup_ms);
+    if (streq(k, "startup.tare"))            return parse_u32(v, &c->startup_tare);
+    if (streq(k, "startup.tare_max_kg"))     return parse_f32(v, &c->startup_tare_max_kg);
+    if (streq(k, "startup.tare_timeout_ms")) return parse_u32(v, &c->startup_tare_timeout_ms);
+
+    // Zero tracking
+    if (streq(k, "zero.track"))         return parse_u32(v, &c->zero_track);
+    if (streq(k, "zero.band_kg"))       return parse_f32(v, &c->zero_band_kg);
+    if (streq(k, "zero.rate_kg_s"))     return parse_f32(v, &c->zero_rate_kg_s);
+    if (streq(k, "zero.hold_ms"))       return parse_u32(v, &c->zero_hold_ms);
+    if (streq(k, "zero.persist_s"))     return parse_u32(v, &c->zero_persist_s);
+    if (streq(k, "zero.state_path")) {
+        strncpy(c->zero_state_path, v, sizeof(c->zero_state_path)-1);
+        c->zero_state_path[sizeof(c->zero_state_path)-1] = '\0';
+        return 0;
+    }
+
+    // Filtering
+    if (streq(k, "filter.chain"))       return scale_filter_parse_chain(&c->filter, v);
+    if (streq(k, "filter.median_len"))  return parse_u8(v, &c->filter.median_len);
+    if (streq(k, "filter.mad_len"))     return parse_u8(v, &c->filter.mad_len);
+    if (streq(k, "filter.mad_k"))       return parse_q8_u16(v, &c->filter.mad_k_q8);
+    if (streq(k, "filter.mad_min_cts")) return parse_i32(v, &c->filter.mad_min_cts);
+    if (streq(k, "filter.ema_alpha"))   return parse_alpha_q16(v, &c->filter.ema_alpha_q16);
+    if (streq(k, "filter.fir_taps"))    return scale_filter_parse_taps(&c->filter, v);
+
     // Logging
     if (streq(k, "log.csv_path")) {
         strncpy(c->csv_path, v, sizeof(c->csv_path)-1);
         c->csv_path[sizeof(c->csv_path)-1] = '\0';
         return 0;
     }
+    if (streq(k, "log.flush_ms"))     return parse_u32(v, &c->log_flush_ms);
+    if (streq(k, "log.fsync"))        return event_log_parse_fsync(v, &c->log_fsync);
+    if (streq(k, "log.rotate_kb"))    return parse_u32(v, &c->log_rotate_kb);
+    if (streq(k, "log.rotate_daily")) return parse_u32(v, &c->log_rotate_daily);
+
+    // Telemetry
+    if (streq(k, "telemetry.path")) {
+        strncpy(c->tlm_path, v, sizeof(c->tlm_path)-1);
+        c->tlm_path[sizeof(c->tlm_path)-1] = '\0';
+        return 0;
+    }
+    if (streq(k, "telemetry.records")) return parse_u32(v, &c->tlm_records);
 
     // Unknown key: ignore
     return 0;
@@ -169,3 +290,41 @@ int config_load_file(app_config_t *c, const char *path){
     fclose(f);
     return any_parse_error ? -2 : 0;
 }
+
+int config_validate(const app_config_t *c, char *err, size_t err_len){
+    const char *why = NULL;
+    if (!c)                                             why = "no config";
+    else if (!(c->hx_counts_per_kg > 0.0f || c->hx_counts_per_kg < 0.0f)) why = "hx.counts_per_kg must be non-zero";
+    else if (c->hx_channels == 0 || c->hx_channels > HX711_MAX_CHANNELS) why = "hx.channels must be 1..8";
+    else if (c->hx_rate_sps != 10u && c->hx_rate_sps != 80u) why = "hx.rate_sps must be 10 or 80";
+    else if (c->move_speed_sps == 0)                    why = "move.speed_sps must be > 0";
+    else if (c->move_acc_sps2 == 0)                     why = "move.acc_sps2 must be > 0";
+    else if (c->home_dir != 1 && c->home_dir != -1)     why = "home.dir must be +1 or -1";
+    else if (c->home_speed_sps == 0)                    why = "home.speed_sps must be > 0";
+    else if (!(c->trig_treshold > 0.0f))                why = "trigger.treshold must be > 0";
+    else if (c->sample_count == 0 || c->sample_count > 1000u) why = "sample.count must be 1..1000";
+    else if (c->settle_window < 2u || c->settle_window > 64u) why = "settle.window must be 2..64";
+    else if (!(c->settle_band_kg > 0.0f))               why = "settle.band_kg must be > 0";
+    else if (!(c->settle_slope_kg_s > 0.0f))            why = "settle.slope_kg_s must be > 0";
+    else if (c->settle_max_ms == 0)                     why = "settle.max_ms must be > 0";
+    else if (c->zero_track && !(c->zero_band_kg > 0.0f && c->zero_band_kg < c->trig_treshold))
+                                                        why = "zero.band_kg must be > 0 and below trigger.treshold";
+    else if (c->zero_track && !(c->zero_rate_kg_s > 0.0f)) why = "zero.rate_kg_s must be > 0";
+    else if (c->filter.median_len == 0 || c->filter.median_len > SCALE_FILTER_MAX_WIN ||
+             c->filter.mad_len == 0 || c->filter.mad_len > SCALE_FILTER_MAX_WIN)
+                                                        why = "filter window out of range";
+
+    for (unsigned i = 1; !why && c && i < c->hx_channels; i++) {
+        if (!(c->hx_more[i - 1u].counts_per_kg > 0.0f || c->hx_more[i - 1u].counts_per_kg < 0.0f)) {
+            why = "hx.<n>.counts_per_kg must be non-zero";
+        } else if (c->hx_more[i - 1u].dout_line > 63u) {
+            why = "hx.<n>.dout_line out of range";
+        }
+    }
+
+    if (why && err && err_len) {
+        strncpy(err, why, err_len - 1);
+        err[err_len - 1] = '\0';
+    }
+    return why ? -1 : 0;
+}
@@ -1,16 +1,31 @@
 // File: src/config/config.h
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
+#include "scale_filter.h"
+#include "hx711_driver.h"
 
 typedef struct app_config {
     // ---- HX711 calibration ----
     int32_t  hx_tare_offset_cts;
     float    hx_counts_per_kg;
+    uint32_t hx_channels;           // HX711s sharing SCK, 1..HX711_MAX_CHANNELS
+    uint32_t hx_gain;               // hx711_gain_t, all channels
+    uint32_t hx_rate_sps;           // RATE pin strapping, 10 or 80; checked against the measured rate
+    struct {
+        uint32_t dout_line;
+        int32_t  tare_offset_cts;
+        float    counts_per_kg;
+    } hx_more[HX711_MAX_CHANNELS - 1u];     // channel i = hx_more[i - 1], keys hx.<i>.*
+
+    // ---- GPIO ----
+    char     gpio_mmio_path[256];   // register window (/dev/gpiomem0); empty = libgpiod only
 
     // ---- Move target ----
     int32_t move_stp;
     uint32_t move_speed_sps;
     uint32_t move_acc_sps2;
+    uint32_t move_dwell_ms;         // pause at the far end of a deposit stroke
 
     // ---- Homing ----
     int32_t  home_offset_steps;     // after switch hit: set pos = home_offset_steps
@@ -22,12 +37,40 @@ typedef struct app_config {
     float trig_treshold;
 
     // ---- Sampling ----
-    uint32_t settle_ms;             // wait after reaching 0
-    uint32_t sample_count;          // N samples
-    uint32_t sample_period_ms;      // delay between samples
+    uint32_t settle_window;         // samples in the settle detector window
+    float    settle_band_kg;        // stable when stddev over the window <= this
+    float    settle_slope_kg_s;     // ... and |drift| <= this
+    uint32_t settle_max_ms;         // give up on an item that never settles
+    uint32_t sample_count;          // N distinct conversions averaged per item
+    uint32_t sample_period_ms;      // logged only: samples are paced by the ADC
+
+    // ---- Startup ----
+    uint32_t startup_warmup_ms;     // conversions discarded after the HX711 starts
+    uint32_t startup_tare;          // 1 = fresh tare from a stable window while homing
+    float    startup_tare_max_kg;   // refuse a fresh tare this far from the configured one
+    uint32_t startup_tare_timeout_ms;
+
+    // ---- Zero tracking (see zero_track.h) ----
+    uint32_t zero_track;            // 1 = follow drift of the empty scale
+    float    zero_band_kg;          // only within this of zero
+    float    zero_rate_kg_s;        // max tare slew
+    uint32_t zero_hold_ms;          // frozen this long after an item
+    uint32_t zero_persist_s;        // write the live tare this often, 0 = never
+    char     zero_state_path[256];  // live tare survives restarts here; empty = off
+
+    // ---- Filtering (raw counts, before publish) ----
+    scale_filter_cfg_t filter;
 
     // ---- Logging ----
     char     csv_path[256];
+    uint32_t log_flush_ms;          // batch writes this long
+    uint32_t log_fsync;             // event_log_fsync_t
+    uint32_t log_rotate_kb;         // 0 = never rotate by size
+    uint32_t log_rotate_daily;      // 1 = new file when the date changes
+
+    // ---- Binary telemetry ring ----
+    char     tlm_path[256];         // empty = off
+    uint32_t tlm_records;           // ring size in 32-byte records
 } app_config_t;
 
 // Fill cfg with defaults
@@ -36,3 +79,7 @@ void config_set_defaults(app_config_t *cfg);
 // Load config file, overriding defaults.
 // Returns: 0 if loaded OK, -1 if file missing/unreadable (defaults remain), -2 parse error (still best-effort)
 int  config_load_file(app_config_t *cfg, const char *path);
+
+// Range checks for a freshly loaded config. Returns 0 if usable, else -1
+// with the first problem in err.
+int  config_validate(const app_config_t *cfg, char *err, size_t err_len);
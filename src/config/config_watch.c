@@ -0,0 +1,170 @@
+#include "config_watch.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#define DEBOUNCE_MS 100     // editors write in bursts; load once it goes quiet
+
+static struct {
+    char path[256];
+    char dir[256];
+    char base[256];
+
+    int  ino_fd;            // -1 without inotify
+    int  wake_rd, wake_wr;  // self-pipe: config_watch_request() and stop
+    pthread_t th;
+    int  started;
+    atomic_int stop;
+
+    _Atomic(app_config_t*) pending;     // ownership moves with the exchange
+} g = { .ino_fd = -1, .wake_rd = -1, .wake_wr = -1 };
+
+void config_watch_request(void){
+    if (g.wake_wr >= 0) {
+        char c = 'r';
+        ssize_t rc = write(g.wake_wr, &c, 1);
+        (void)rc;
+    }
+}
+
+int config_watch_take(app_config_t *out){
+    app_config_t *c = atomic_exchange_explicit(&g.pending, NULL, memory_order_acquire);
+    if (!c) return 0;
+    if (out) *out = *c;
+    free(c);
+    return 1;
+}
+
+static void reload(void){
+    app_config_t *c = malloc(sizeof(*c));
+    if (!c) return;
+
+    config_set_defaults(c);
+    int rc = config_load_file(c, g.path);
+    char why[128];
+    if (rc != 0) {
+        fprintf(stderr, "config: reload of %s failed (%s), keeping current config\n", g.path,
+                rc == -1 ? "unreadable" : "parse error");
+        free(c);
+        return;
+    }
+    if (config_validate(c, why, sizeof(why)) != 0) {
+        fprintf(stderr, "config: reload rejected: %s\n", why);
+        free(c);
+        return;
+    }
+    free(atomic_exchange_explicit(&g.pending, c, memory_order_acq_rel));
+    fprintf(stderr, "config: reloaded %s, applies at the next cycle\n", g.path);
+}
+
+// 1 if an inotify event names our file
+static int drain_inotify(void){
+    int hit = 0;
+#ifdef __linux__
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t n = read(g.ino_fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (char *p = buf; p < buf + n; ) {
+            const struct inotify_event *ev = (const struct inotify_event*)p;
+            if (ev->len && strcmp(ev->name, g.base) == 0) hit = 1;
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+#endif
+    return hit;
+}
+
+static int drain_pipe(void){
+    char buf[64];
+    int hit = 0;
+    while (read(g.wake_rd, buf, sizeof(buf)) > 0) hit = 1;
+    return hit;
+}
+
+static void* config_watch_fn(void *p){
+    (void)p;
+    struct pollfd pf[2] = {
+        { .fd = g.wake_rd, .events = POLLIN },
+        { .fd = g.ino_fd,  .events = POLLIN },
+    };
+    nfds_t n = (g.ino_fd >= 0) ? 2 : 1;
+    int dirty = 0;
+
+    while (!atomic_load(&g.stop)) {
+        int rc = poll(pf, n, dirty ? DEBOUNCE_MS : -1);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            perror("config watch poll");
+            break;
+        }
+        if (rc == 0) {
+            // quiet for DEBOUNCE_MS after the last change
+            dirty = 0;
+            reload();
+            continue;
+        }
+        if ((pf[0].revents & POLLIN) && drain_pipe()) dirty = 1;
+        if (n == 2 && (pf[1].revents & POLLIN) && drain_inotify()) dirty = 1;
+    }
+    return NULL;
+}
+
+int config_watch_start(const char *path){
+    if (!path || g.started) return -1;
+
+    strncpy(g.path, path, sizeof(g.path) - 1);
+    const char *slash = strrchr(g.path, '/');
+    if (slash) {
+        size_t dl = (size_t)(slash - g.path);
+        if (dl == 0) dl = 1;    // "/config.txt"
+        if (dl >= sizeof(g.dir)) return -1;
+        memcpy(g.dir, g.path, dl);
+        g.dir[dl] = '\0';
+        snprintf(g.base, sizeof(g.base), "%s", slash + 1);
+    } else {
+        strcpy(g.dir, ".");
+        snprintf(g.base, sizeof(g.base), "%s", g.path);
+    }
+
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) return -2;
+    g.wake_rd = fds[0];
+    g.wake_wr = fds[1];
+
+#ifdef __linux__
+    g.ino_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (g.ino_fd >= 0 &&
+        inotify_add_watch(g.ino_fd, g.dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        perror("config watch inotify");
+        close(g.ino_fd);
+        g.ino_fd = -1;
+    }
+#endif
+    if (g.ino_fd < 0) fprintf(stderr, "config: no file watch, reload with SIGHUP only\n");
+
+    atomic_store(&g.stop, 0);
+    if (pthread_create(&g.th, NULL, config_watch_fn, NULL) != 0) return -3;
+    g.started = 1;
+    return 0;
+}
+
+void config_watch_stop(void){
+    if (!g.started) return;
+    atomic_store(&g.stop, 1);
+    config_watch_request();
+    pthread_join(g.th, NULL);
+    g.started = 0;
+    free(atomic_exchange(&g.pending, NULL));
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "config.h"
+
+/*
+    Live reload of config.txt. A watcher thread reloads the file when it
+    changes on disk (inotify on its directory, so editors that replace the
+    file are seen too) or when config_watch_request() is called, e.g. from
+    a SIGHUP handler. Each reload starts from defaults, must parse cleanly
+    and pass config_validate(); otherwise it is reported and dropped.
+
+    The accepted config is parked for the control loop, which picks it up
+    with config_watch_take() at a cycle boundary.
+*/
+
+int  config_watch_start(const char *path);
+void config_watch_stop(void);
+
+// Async-signal-safe.
+void config_watch_request(void);
+
+// 1 and *out replaced if a new config is waiting, else 0.
+int  config_watch_take(app_config_t *out);
@@ -2,90 +2,358 @@
 #include "core.h"
 
 #include <signal.h>
+#include <pthread.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdatomic.h>
-#include <sys/stat.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
 
+#include "gpio_backend.h"
+#include "gpio_mmio.h"
 #include "stepper_driver.h"
 #include "stepper_thread.h"
 #include "hx711_driver.h"
 #include "hx711_thread.h"
 #include "shared.h"
 #include "config.h"
+#include "config_watch.h"
+#include "settle.h"
+#include "deposit.h"
+#include "zero_track.h"
+#include "event_log.h"
+#include "telemetry.h"
+
+static uint64_t mono_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
 
-static void nsleep_ms(long ms){
-    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
-    (void)nanosleep(&ts, 0);
+static uint64_t real_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
 }
 
-static int file_is_empty(const char *path){
-    struct stat st;
-    if (stat(path, &st) != 0) return 1;
-    return (st.st_size == 0);
+static uint32_t ms_between(uint64_t a_ns, uint64_t b_ns){
+    return (b_ns > a_ns) ? (uint32_t)((b_ns - a_ns) / 1000000u) : 0u;
 }
 
-static void append_csv(const char *path, double avg_kg, const app_config_t *cfg){
-    FILE *f = fopen(path, "a");
-    if (!f) {
-        perror("csv fopen");
-        return;
+// ---- startup ----
+
+// Scale branch of the startup graph: runs on its own thread while the RT
+// thread homes. Waits out the HX711 warm-up, then takes a fresh tare from
+// the first stable window.
+typedef struct {
+    const app_config_t *cfg;
+    uint64_t t0_ns;
+    uint32_t first_ms, warm_ms, tare_ms;    // since t0, 0 = not reached
+    int32_t  tare;
+    int      tared;                         // 1 = tare holds a fresh value
+    double   tare_delta_kg;
+} scale_boot_t;
+
+static int next_sample(uint32_t *seq, scale_sample_t *out, uint32_t timeout_ms){
+    for (;;) {
+        if (scale_ring_wait(&g_scale_ring, *seq, timeout_ms) < 0) return -1;
+        if (scale_ring_since(&g_scale_ring, *seq, out, 1) == 1) {
+            *seq = out->seq;
+            return 0;
+        }
+        *seq = scale_ring_seq(&g_scale_ring);  // overwritten under us: resync
     }
+}
+
+static void* scale_boot_fn(void *p){
+    scale_boot_t *b = (scale_boot_t*)p;
+    const app_config_t *cfg = b->cfg;
+    uint32_t seq = scale_ring_seq(&g_scale_ring);
+    scale_sample_t s;
 
-    if (file_is_empty(path)) {
-        fprintf(f, "settle time, sample period, avg_kg\n");
+    if (next_sample(&seq, &s, 2000u) < 0) {
+        fprintf(stderr, "[START] no conversion from HX711 in 2 s\n");
+        return NULL;
     }
+    b->first_ms = ms_between(b->t0_ns, mono_ns());
 
-    fprintf(f, "%i, %i, %.3f\n", cfg->settle_ms, cfg->sample_period_ms, avg_kg);
-    fclose(f);
+    uint64_t warm_until = s.t_ns + (uint64_t)cfg->startup_warmup_ms * 1000000u;
+    while (s.t_ns < warm_until) {
+        if (next_sample(&seq, &s, 2000u) < 0) return NULL;
+    }
+    b->warm_ms = ms_between(b->t0_ns, mono_ns());
+    if (!cfg->startup_tare) return NULL;
+
+    settle_cfg_t scfg = {
+        .window = cfg->settle_window,
+        .band_kg = cfg->settle_band_kg,
+        .slope_kg_s = cfg->settle_slope_kg_s,
+        .max_ms = cfg->startup_tare_timeout_ms,
+    };
+    settle_t st;
+    settle_init(&st, &scfg);
+    uint64_t give_up = s.t_ns + (uint64_t)cfg->startup_tare_timeout_ms * 1000000u;
+    for (;;) {
+        if (next_sample(&seq, &s, 2000u) < 0) return NULL;
+        if (settle_push(&st, s.kg, s.t_ns)) break;
+        if (s.t_ns >= give_up) {
+            fprintf(stderr, "[START] scale never stable, keeping configured tare\n");
+            return NULL;
+        }
+    }
+
+    // samples are in kg against the configured tare, so the mean is the zero shift
+    b->tare_delta_kg = st.mean_kg;
+    if (fabs(st.mean_kg) > (double)cfg->startup_tare_max_kg) {
+        fprintf(stderr, "[START] fresh tare is %.4f kg off, keeping configured tare (item on the scale?)\n",
+                st.mean_kg);
+        return NULL;
+    }
+    b->tare = cfg->hx_tare_offset_cts + (int32_t)lround(st.mean_kg * (double)cfg->hx_counts_per_kg);
+    b->tared = 1;
+    b->tare_ms = ms_between(b->t0_ns, mono_ns());
+    return NULL;
 }
 
-static void weigh_and_log(const volatile sig_atomic_t *running, const app_config_t *cfg) {
-    double sum = 0.0;
-    uint32_t n = (cfg->sample_count == 0) ? 1u : cfg->sample_count;
-    for (uint32_t i = 0; i < n && *running; i++) {
-        float kg = atomic_load(&g_scale_kg);
-        sum += (double)kg;
-        nsleep_ms((long)cfg->sample_period_ms);
+// Calibration of every configured channel, channel 0 first. Returns the count.
+static unsigned scale_cal(const app_config_t *cfg, hx711_cal_t *cal){
+    cal[0] = (hx711_cal_t){ .tare_offset_cts = cfg->hx_tare_offset_cts, .counts_per_kg = cfg->hx_counts_per_kg };
+    for (unsigned i = 1; i < cfg->hx_channels; i++) {
+        cal[i] = (hx711_cal_t){ .tare_offset_cts = cfg->hx_more[i - 1u].tare_offset_cts,
+                                .counts_per_kg = cfg->hx_more[i - 1u].counts_per_kg };
     }
-    double avg = sum / (double)n;
-    if (!*running) return;
-    // 6) append to csv
-    append_csv(cfg->csv_path, avg, cfg);
-    fprintf(stderr, "logged avg=%.6f kg to %s\n", avg, cfg->csv_path);
+    return cfg->hx_channels;
 }
 
-static void weight_treshold(const volatile sig_atomic_t *running, const app_config_t *cfg, stepper_motor *m1) {
-    if (!running || !cfg || !m1 || !*running) return;
+// tare value last read from config.txt; a reload only overrides the live
+// tare when the file's value itself changed
+static int32_t tare_from_file;
+
+// Take a reloaded config, if any, at a cycle boundary. Motion, trigger,
+// sampling and settle values apply from the next item; the HX711 thread
+// gets the new filter and calibration before its next conversion. Files
+// that are already open and the homing parameters keep their current
+// values until the next restart. Returns 1 if new settings were taken.
+static int apply_reload(app_config_t *cfg){
+    app_config_t n;
+    if (!config_watch_take(&n)) return 0;
+
+    if (strcmp(n.csv_path, cfg->csv_path) != 0 || n.log_flush_ms != cfg->log_flush_ms ||
+        n.log_fsync != cfg->log_fsync || n.log_rotate_kb != cfg->log_rotate_kb ||
+        n.log_rotate_daily != cfg->log_rotate_daily ||
+        strcmp(n.tlm_path, cfg->tlm_path) != 0 || n.tlm_records != cfg->tlm_records) {
+        fprintf(stderr, "config: log.* / telemetry.* changes take effect after a restart\n");
+    }
+    int lines_changed = (n.hx_channels != cfg->hx_channels || n.hx_gain != cfg->hx_gain);
+    for (unsigned i = 0; i + 1u < n.hx_channels && !lines_changed; i++) {
+        lines_changed = (n.hx_more[i].dout_line != cfg->hx_more[i].dout_line);
+    }
+    if (lines_changed || strcmp(n.gpio_mmio_path, cfg->gpio_mmio_path) != 0) {
+        fprintf(stderr, "config: gpio.mmio_path / hx.channels / hx.gain / hx.<n>.dout_line changes take effect after a restart\n");
+    }
+    if (n.home_offset_steps != cfg->home_offset_steps || n.home_dir != cfg->home_dir ||
+        n.home_speed_sps != cfg->home_speed_sps || n.home_acc_sps2 != cfg->home_acc_sps2) {
+        fprintf(stderr, "config: home.* changes take effect at the next homing (restart)\n");
+    }
+    memcpy(n.csv_path, cfg->csv_path, sizeof(n.csv_path));
+    n.log_flush_ms     = cfg->log_flush_ms;
+    n.log_fsync        = cfg->log_fsync;
+    n.log_rotate_kb    = cfg->log_rotate_kb;
+    n.log_rotate_daily = cfg->log_rotate_daily;
+    memcpy(n.tlm_path, cfg->tlm_path, sizeof(n.tlm_path));
+    n.tlm_records      = cfg->tlm_records;
+    n.home_offset_steps = cfg->home_offset_steps;
+    n.home_dir          = cfg->home_dir;
+    n.home_speed_sps    = cfg->home_speed_sps;
+    n.home_acc_sps2     = cfg->home_acc_sps2;
+    n.hx_channels       = cfg->hx_channels;
+    n.hx_gain           = cfg->hx_gain;
+    for (unsigned i = 0; i < HX711_MAX_CHANNELS - 1u; i++) n.hx_more[i].dout_line = cfg->hx_more[i].dout_line;
+
+    if (n.hx_tare_offset_cts == tare_from_file) n.hx_tare_offset_cts = cfg->hx_tare_offset_cts;
+    else tare_from_file = n.hx_tare_offset_cts;
+
+    hx711_cal_t cal_old[HX711_MAX_CHANNELS], cal_new[HX711_MAX_CHANNELS];
+    unsigned nch = scale_cal(cfg, cal_old);
+    (void)scale_cal(&n, cal_new);
+    if (memcmp(&n.filter, &cfg->filter, sizeof(n.filter)) != 0 ||
+        memcmp(cal_new, cal_old, nch * sizeof(cal_new[0])) != 0) {
+        if (hx711_thread_reconfigure(&n.filter, cal_new, nch) != 0) {
+            fprintf(stderr, "config: out of memory, scale settings not updated\n");
+            n.filter = cfg->filter;
+            n.hx_tare_offset_cts = cfg->hx_tare_offset_cts;
+            n.hx_counts_per_kg = cfg->hx_counts_per_kg;
+            memcpy(n.hx_more, cfg->hx_more, sizeof(n.hx_more));
+        }
+    }
+
+    memcpy(n.zero_state_path, cfg->zero_state_path, sizeof(n.zero_state_path));
+    memcpy(n.gpio_mmio_path, cfg->gpio_mmio_path, sizeof(n.gpio_mmio_path));
 
-    float w0 = atomic_load(&g_scale_kg);
-    if (w0 <= cfg->trig_treshold) return;
+    *cfg = n;
+    fprintf(stderr, "config: new settings active\n");
+    return 1;
+}
 
-    nsleep_ms((long)cfg->settle_ms);
-    if (!*running) return;
+// ---- zero tracking ----
+
+// The live tare is kept in a small state file next to the logs, never in
+// config.txt, so techs' edits and our writes cannot collide. It records
+// the config.txt tare it was derived from: once that value is edited, the
+// file's value wins again.
+static int tare_state_load(const char *path, int32_t base, int32_t *out){
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char line[128];
+    long tare = 0, b = 0;
+    int have = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, " tare_offset_cts = %ld", &tare) == 1) have |= 1;
+        else if (sscanf(line, " base_cts = %ld", &b) == 1) have |= 2;
+    }
+    fclose(f);
+    if (have != 3 || b != (long)base) return -1;
+    *out = (int32_t)tare;
+    return 0;
+}
 
-    float w1 = atomic_load(&g_scale_kg);
-    if (w1 < cfg->trig_treshold) return;
+// write-then-rename, so a power cut leaves the old file or the new one
+static int tare_state_save(const char *path, int32_t tare, int32_t base){
+    char tmp[300];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    fprintf(f, "# live tare from zero tracking, used while config.txt has hx.tare_offset_cts = %ld\n"
+               "tare_offset_cts = %ld\nbase_cts = %ld\n", (long)base, (long)tare, (long)base);
+    int rc = (fflush(f) == 0 && fsync(fileno(f)) == 0) ? 0 : -1;
+    if (fclose(f) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if (rc != 0) unlink(tmp);
+    return rc;
+}
 
-    float dw = w1 - w0;
-    if (dw < 0.005f) dw = -dw;
-    if (dw > 0.005f) return;
+static struct {
+    zero_track_t zt;
+    uint32_t seq;               // last conversion fed to the tracker
+    int32_t  saved;             // tare in the state file
+    uint64_t saved_ns;
+} ztrack;
+
+static void zero_reset(const app_config_t *cfg){
+    zero_track_cfg_t zc = {
+        .band_kg = cfg->zero_band_kg,
+        .rate_kg_s = cfg->zero_rate_kg_s,
+        .hold_ms = cfg->zero_hold_ms,
+        .settle = {
+            .window = cfg->settle_window,
+            .band_kg = cfg->settle_band_kg,
+            .slope_kg_s = cfg->settle_slope_kg_s,
+            .max_ms = cfg->settle_max_ms,
+        },
+    };
+    zero_track_init(&ztrack.zt, &zc, cfg->hx_tare_offset_cts, cfg->hx_counts_per_kg);
+    ztrack.seq = scale_ring_seq(&g_scale_ring);
+}
 
-    weigh_and_log(running, cfg);
+// Feed the conversions since the last call to the tracker and hand tare
+// moves to the HX711 thread. Called between items only.
+static void zero_tick(app_config_t *cfg){
+    if (!cfg->zero_track) return;
+    scale_sample_t buf[16];
+    int moved = 0;
+    for (;;) {
+        size_t k = scale_ring_since(&g_scale_ring, ztrack.seq, buf, sizeof(buf) / sizeof(buf[0]));
+        if (k == 0) {
+            ztrack.seq = scale_ring_seq(&g_scale_ring);  // caught up, or overwritten: resync
+            break;
+        }
+        for (size_t i = 0; i < k; i++) {
+            ztrack.seq = buf[i].seq;
+            moved |= zero_track_push(&ztrack.zt, buf[i].raw, buf[i].t_ns);
+        }
+    }
+    if (moved) {
+        cfg->hx_tare_offset_cts = zero_track_tare(&ztrack.zt);
+        hx711_thread_set_tare(0, cfg->hx_tare_offset_cts);
+    }
+}
 
-    (void)stepper_start_move_abs(m1, cfg->move_stp, cfg->move_speed_sps, cfg->move_acc_sps2);
-    while (*running && m1->state == STP_MOVING) nsleep_ms(10);
-    if (!*running) return;
+static void zero_persist(const app_config_t *cfg, uint64_t now_ns, int force){
+    if (!cfg->zero_state_path[0] || cfg->hx_tare_offset_cts == ztrack.saved) return;
+    if (!force && (cfg->zero_persist_s == 0 ||
+                   now_ns - ztrack.saved_ns < (uint64_t)cfg->zero_persist_s * 1000000000u)) return;
+    ztrack.saved_ns = now_ns;
+    if (tare_state_save(cfg->zero_state_path, cfg->hx_tare_offset_cts, tare_from_file) != 0) {
+        fprintf(stderr, "zero: cannot write %s\n", cfg->zero_state_path);
+        return;
+    }
+    fprintf(stderr, "zero: tare %ld saved (%+ld cts since last save)\n",
+            (long)cfg->hx_tare_offset_cts, (long)(cfg->hx_tare_offset_cts - ztrack.saved));
+    ztrack.saved = cfg->hx_tare_offset_cts;
+}
 
-    (void)stepper_start_move_abs(m1, 0, cfg->move_speed_sps, cfg->move_acc_sps2);
-    while (*running && m1->state == STP_MOVING) nsleep_ms(10);
+static void print_rt_stats(void){
+    stepper_rt_stats_t st;
+    stepper_thread_get_stats(&st);
+    printf("rt: wake p50=%llu p99=%llu max=%llu ns | exec p99=%llu max=%llu ns | missed=%llu late_edges=%llu/%llu (max %llu us)\n",
+           (unsigned long long)stepper_rt_hist_quantile(st.wake_hist, 0.50),
+           (unsigned long long)stepper_rt_hist_quantile(st.wake_hist, 0.99),
+           (unsigned long long)st.wake_max_ns,
+           (unsigned long long)stepper_rt_hist_quantile(st.exec_hist, 0.99),
+           (unsigned long long)st.exec_max_ns,
+           (unsigned long long)st.missed, (unsigned long long)st.late_edges,
+           (unsigned long long)st.edges, (unsigned long long)st.edge_late_max_us);
+}
+
+// Block until the stepper finishes command seq. Wakes on the transition
+// itself; the timeout only bounds how long a stop request goes unnoticed.
+static int wait_motion(const volatile sig_atomic_t *running, stepper_motor *m, uint32_t seq){
+    if (seq == 0) return -1;
+    while (*running) {
+        int rc = stepper_wait_done(m, seq, 100u);
+        if (rc != -1) return rc;
+    }
+    return -1;
+}
+
+static void deposit_cfg_from(const app_config_t *cfg, deposit_cfg_t *out){
+    *out = (deposit_cfg_t){
+        .trig_kg = cfg->trig_treshold,
+        .sample_count = cfg->sample_count,
+        .settle = {
+            .window = cfg->settle_window,
+            .band_kg = cfg->settle_band_kg,
+            .slope_kg_s = cfg->settle_slope_kg_s,
+            .max_ms = cfg->settle_max_ms,
+        },
+        .move_stp = cfg->move_stp,
+        .speed_sps = cfg->move_speed_sps,
+        .acc_sps2 = cfg->move_acc_sps2,
+        .dwell_ms = cfg->move_dwell_ms,
+    };
+}
+
+static void print_deposit_stats(const deposit_t *d){
+    static const char *const name[DEP_STAGES] = { "settle", "weigh", "wait", "out", "back", "cycle" };
+    const deposit_stats_t *st = &d->stats;
+    if (st->items == 0) return;
+    printf("deposit: items=%llu skipped=%llu held=%llu rearm_in_stroke=%llu rate=%.1f/min |",
+           (unsigned long long)st->items, (unsigned long long)st->skipped, (unsigned long long)st->held,
+           (unsigned long long)st->rearms_in_stroke, deposit_rate_per_min(d));
+    for (unsigned i = 0; i < DEP_STAGES; i++) {
+        printf(" %s %llu/%u", name[i], (unsigned long long)(st->stage[i].sum_ms / st->items), st->stage[i].max_ms);
+    }
+    printf(" ms (avg/max)\n");
 }
 
 void start_core(const volatile sig_atomic_t* running){
     app_config_t cfg;
     config_set_defaults(&cfg);
 
-    int rc = config_load_file(&cfg, "/home/pi5/dev/Wingo_deposit_machine/config.txt");
+    const char *cfg_path = "/home/pi5/dev/Wingo_deposit_machine/config.txt";
+    int rc = config_load_file(&cfg, cfg_path);
     if (rc == -1) {
         fprintf(stderr, "config: config.txt not found, using defaults\n");
     } else if (rc == -2) {
@@ -93,6 +361,53 @@ void start_core(const volatile sig_atomic_t* running){
     } else {
         fprintf(stderr, "config: loaded config.txt\n");
     }
+    char why[128];
+    if (config_validate(&cfg, why, sizeof(why)) != 0) {
+        fprintf(stderr, "config: %s\n", why);
+        return;
+    }
+    // Register-mapped pins if configured; edge events (HX711 DOUT) and any
+    // failure stay with the backend main() selected. The mapping is never
+    // torn down: the sampling threads are not joined.
+    if (cfg.gpio_mmio_path[0]) {
+        const gpio_backend_t *prev = gpio_active;
+        if (gpio_mmio_open(cfg.gpio_mmio_path, prev) == 0) {
+            gpio_set_backend(&gpio_mmio_backend);
+            fprintf(stderr, "gpio: registers mapped from %s, edges via %s\n",
+                    cfg.gpio_mmio_path, prev ? prev->name : "none");
+        } else {
+            fprintf(stderr, "gpio: cannot map %s (%s), using %s\n", cfg.gpio_mmio_path,
+                    strerror(errno), prev ? prev->name : "none");
+        }
+    }
+
+    tare_from_file = cfg.hx_tare_offset_cts;
+    if (cfg.zero_state_path[0]) {
+        int32_t live;
+        if (tare_state_load(cfg.zero_state_path, tare_from_file, &live) == 0) {
+            fprintf(stderr, "zero: tare %ld from %s (config.txt has %ld)\n",
+                    (long)live, cfg.zero_state_path, (long)tare_from_file);
+            cfg.hx_tare_offset_cts = live;
+        }
+    }
+    ztrack.saved = cfg.hx_tare_offset_cts;
+    (void)config_watch_start(cfg_path);
+    uint64_t t0 = mono_ns();
+
+    event_log_cfg_t lcfg = {
+        .path = cfg.csv_path,
+        .flush_ms = cfg.log_flush_ms,
+        .fsync = cfg.log_fsync,
+        .rotate_bytes = (uint64_t)cfg.log_rotate_kb * 1024u,
+        .rotate_daily = cfg.log_rotate_daily,
+    };
+    if (event_log_start(&lcfg) < 0) {
+        fprintf(stderr, "log: cannot open %s, items will not be logged\n", cfg.csv_path);
+    }
+
+    if (cfg.tlm_path[0] && telemetry_open(cfg.tlm_path, cfg.tlm_records) < 0) {
+        fprintf(stderr, "telemetry: cannot map %s, recording off\n", cfg.tlm_path);
+    }
 
     hx711_t scale = {
         .gpiochip = "/dev/gpiochip4",
@@ -100,7 +415,15 @@ void start_core(const volatile sig_atomic_t* running){
         .dout_line = 5,
         .tare_offset_cts = cfg.hx_tare_offset_cts,
         .counts_per_kg   = cfg.hx_counts_per_kg,
+        .gain     = (uint8_t)cfg.hx_gain,
+        .channels = (uint8_t)cfg.hx_channels,
     };
+    // more converters on the same SCK; channel 0 drives the deposit trigger
+    for (unsigned i = 1; i < cfg.hx_channels; i++) {
+        scale.more[i - 1u].dout_line = (uint8_t)cfg.hx_more[i - 1u].dout_line;
+        scale.more[i - 1u].cal = (hx711_cal_t){ .tare_offset_cts = cfg.hx_more[i - 1u].tare_offset_cts,
+                                                .counts_per_kg = cfg.hx_more[i - 1u].counts_per_kg };
+    }
 
     stepper_motor m1 = {
         .gpiochip = "/dev/gpiochip4",
@@ -119,62 +442,146 @@ void start_core(const volatile sig_atomic_t* running){
     };
 
     if (stepper_init(&m1) < 0) return;
-    if (stepper_enable(&m1) < 0) return;
 
+    // Startup graph: the motor branch (enable -> backoff -> homing -> offset
+    // -> move to 0) runs on the RT thread, the scale branch (warm-up ->
+    // fresh tare) on its own thread. Deposits start once both are done.
+    scale_boot_t boot = { .cfg = &cfg, .t0_ns = t0, .tare = cfg.hx_tare_offset_cts };
+    pthread_t boot_th;
+    int boot_started = 0;
     if (hx711_init(&scale) == 0) {
-        (void)hx711_thread_start(running, &scale);
+        (void)hx711_thread_start(running, &scale, &cfg.filter);
+        boot_started = (pthread_create(&boot_th, NULL, scale_boot_fn, &boot) == 0);
+    } else {
+        fprintf(stderr, "[START] HX711 init failed\n");
     }
 
+    // from here on the RT thread owns the motor; we only post commands
     (void)stepper_thread_start(running, &m1, 80, 2);
 
-    int raw = -1, active = 0;
-    int rr = stepper_home_read(&m1, &raw, &active); // modify to give only active not raw value.
-    if (active && rr == 0) {
-        const int32_t backoff_steps = 500;
-        int32_t delta = (int32_t)(-cfg.home_dir) * backoff_steps;
+    uint32_t t_enable = 0, t_backoff = 0, t_homed = 0, t_zero = 0;
+    int motor_ok = 0;
+    do {
+        uint32_t en = stepper_queue_enable(&m1, 1);
+        if (wait_motion(running, &m1, en) < 0) break;
+        t_enable = ms_between(t0, mono_ns());
+
+        stepper_status_t st;
+        stepper_get_status(&m1, &st);
+        if (st.home_active) {
+            const int32_t backoff_steps = 500;
+            int32_t delta = (int32_t)(-cfg.home_dir) * backoff_steps;
+
+            fprintf(stderr, "[HOME] switch already active -> backoff %ld steps (delta=%ld)\n",
+                    (long)backoff_steps, (long)delta);
+
+            uint32_t seq = stepper_queue_move_rel(&m1, delta, cfg.home_speed_sps, cfg.home_acc_sps2);
+            if (wait_motion(running, &m1, seq) < 0) break;
+            t_backoff = ms_between(t0, mono_ns());
+        }
 
-        fprintf(stderr, "[HOME] switch already active -> backoff %ld steps (delta=%ld)\n",
-                (long)backoff_steps, (long)delta);
+        // homing, offset and the move to 0 run back to back on the RT thread
+        uint32_t home = stepper_queue_homing(&m1, cfg.home_speed_sps, cfg.home_acc_sps2, (int8_t)cfg.home_dir);
+        (void)stepper_queue_set_pos(&m1, cfg.home_offset_steps);
+        uint32_t zero = stepper_queue_move_abs(&m1, 0, cfg.home_speed_sps, cfg.home_acc_sps2);
+        if (wait_motion(running, &m1, home) < 0) break;
+        t_homed = ms_between(t0, mono_ns());
+        if (wait_motion(running, &m1, zero) < 0) break;
+        t_zero = ms_between(t0, mono_ns());
+
+        stepper_get_status(&m1, &st);
+        if (!st.homed) {
+            fprintf(stderr, "[HOME] homing did not complete\n");
+            break;
+        }
+        motor_ok = 1;
+    } while (0);
 
-        (void)stepper_start_move_rel(&m1, delta, cfg.home_speed_sps, cfg.home_acc_sps2);
+    if (boot_started) pthread_join(boot_th, NULL);
+    if (!motor_ok) return;
 
-        while (*running && m1.state == STP_MOVING) {
-            nsleep_ms(20);
-        }
-        if (!*running) return;
+    if (boot.tared) {
+        hx711_thread_set_tare(0, boot.tare);
+        fprintf(stderr, "[START] tare %ld -> %ld (%+.4f kg)\n", (long)cfg.hx_tare_offset_cts,
+                (long)boot.tare, boot.tare_delta_kg);
+        cfg.hx_tare_offset_cts = boot.tare;
+    }
+    fprintf(stderr, "[START] motor: enable=%u backoff=%u homed=%u zero=%u ms | "
+                    "scale: first=%u warm=%u tare=%u ms | ready=%u ms\n",
+            t_enable, t_backoff, t_homed, t_zero, boot.first_ms, boot.warm_ms, boot.tare_ms,
+            ms_between(t0, mono_ns()));
+    // the RATE pin is a strap, not software: only report a mismatch
+    unsigned sps = hx711_thread_rate_sps();
+    if (sps && sps != cfg.hx_rate_sps) {
+        fprintf(stderr, "[START] HX711 converts at %u SPS, hx.rate_sps = %u (check the RATE pin)\n",
+                sps, (unsigned)cfg.hx_rate_sps);
     }
-
     fflush(stderr);
 
-    m1.homed = 0;
-    (void)stepper_start_homing(&m1, cfg.home_speed_sps, cfg.home_acc_sps2, (int8_t)cfg.home_dir);
+    zero_reset(&cfg);
+    ztrack.saved_ns = mono_ns();
 
-    while (*running && m1.homed == 0) {
-        nsleep_ms(20);
-    }
-    if (!*running) return;
+    deposit_cfg_t dcfg;
+    deposit_cfg_from(&cfg, &dcfg);
+    static deposit_t dep;
+    deposit_init(&dep, &dcfg, scale_ring_seq(&g_scale_ring));
 
-    stepper_set_pos(&m1, cfg.home_offset_steps);
-    (void)stepper_start_move_abs(&m1, 0, cfg.home_speed_sps, cfg.home_acc_sps2);
+    unsigned loop = 0;
+    uint64_t next_print_ns = 0;
+    while (*running) {
+        // Wake on whichever comes first: the stroke transition we are
+        // waiting for (bounded, so conversions are still taken within
+        // 10 ms), or the next conversion when no stroke is in flight.
+        uint32_t motion = deposit_wait_seq(&dep);
+        if (motion) (void)stepper_wait_done(&m1, motion, 10u);
+        else (void)scale_ring_wait(&g_scale_ring, dep.seq, 200u);
+
+        if (apply_reload(&cfg)) {
+            zero_reset(&cfg);
+            deposit_cfg_from(&cfg, &dcfg);
+            deposit_set_cfg(&dep, &dcfg);
+        }
 
-    while (*running && m1.state == STP_MOVING) {
-        nsleep_ms(20);
-    }
-    if (!*running) return;
+        deposit_poll(&dep, &m1, mono_ns());
+        scale_sample_t buf[16];
+        size_t k;
+        while ((k = scale_ring_since(&g_scale_ring, dep.seq, buf, sizeof(buf) / sizeof(buf[0]))) > 0) {
+            uint64_t t_real = real_ns();
+            for (size_t i = 0; i < k; i++) deposit_feed(&dep, &m1, &buf[i], t_real);
+        }
 
-    nsleep_ms((long)cfg.settle_ms);
+        // zero tracking only while no item is anywhere in the pipeline
+        if (deposit_idle(&dep)) {
+            zero_tick(&cfg);
+        } else {
+            zero_track_freeze(&ztrack.zt, mono_ns());
+            ztrack.seq = scale_ring_seq(&g_scale_ring);
+        }
+        zero_persist(&cfg, mono_ns(), 0);
 
-    while (*running) {
-        float weight = atomic_load(&g_scale_kg);
-        weight_treshold(running, &cfg, &m1);
-        int raw_scale = atomic_load(&scale_raw_value);
+        uint64_t now = mono_ns();
+        if (now < next_print_ns) continue;
+        next_print_ns = now + 200u * 1000000u;
+        scale_snapshot_t s;
+        scale_state_get(&g_scale_state, &s);
         // float deg = stepper_get_pos_deg(&m1);
-        printf("scale = %.3f kg | raw_scale = %i\n",
-               weight, raw_scale);
+        if (s.status == SCALE_OK) {
+            printf("scale = %.3f kg | raw_scale = %i | age = %u ms\n",
+                   s.kg, s.raw, ms_between(s.t_ns, now));
+        } else {
+            printf("scale = --- (%s)\n", s.status == SCALE_TIMEOUT ? "HX711 not converting" : "no conversion yet");
+        }
+        if (++loop % 50u == 0) {
+            print_rt_stats();
+            print_deposit_stats(&dep);
+        }
         fflush(stdout);
-        nsleep_ms(200);
     }
 
+    zero_persist(&cfg, mono_ns(), 1);
+    config_watch_stop();
     hx711_close(&scale);
-    (void)stepper_disable(&m1);
+    stepper_thread_join();
+    event_log_stop();
+    telemetry_close();
 }
@@ -0,0 +1,222 @@
+#include "deposit.h"
+#include "event_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t ms_between(uint64_t a_ns, uint64_t b_ns){
+    return (b_ns > a_ns) ? (uint32_t)((b_ns - a_ns) / 1000000u) : 0u;
+}
+
+static uint32_t sample_count(const deposit_t *d){
+    return d->cfg.sample_count ? d->cfg.sample_count : 1u;
+}
+
+void deposit_init(deposit_t *d, const deposit_cfg_t *cfg, uint32_t ring_seq){
+    if (!d || !cfg) return;
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    d->phase = DEP_ARMED;
+    d->seq = ring_seq;
+}
+
+void deposit_set_cfg(deposit_t *d, const deposit_cfg_t *cfg){
+    if (d && cfg) d->cfg = *cfg;
+}
+
+// Post cur's whole stroke (the RT thread runs out / dwell / back without
+// waiting on us, queued behind any stroke still running). 0 when there is
+// no room for it yet; the item then stays on the scale in cur.
+static int post(deposit_t *d, stepper_motor *m){
+    if (d->fly_n == DEPOSIT_INFLIGHT) return 0;
+    // out, dwell, back go in as one unit: a stroke that went out without
+    // its way back would leave the arm out and untracked
+    stepper_cmd_t cmd[3];
+    uint32_t seq[3];
+    unsigned n = 0;
+    cmd[n++] = (stepper_cmd_t){ .kind = STP_CMD_MOVE_ABS, .pos_stp = d->cfg.move_stp,
+                                .speed_sps = d->cfg.speed_sps, .acc_sps2 = d->cfg.acc_sps2 };
+    if (d->cfg.dwell_ms) cmd[n++] = (stepper_cmd_t){ .kind = STP_CMD_DWELL, .dwell_us = d->cfg.dwell_ms * 1000u };
+    cmd[n++] = (stepper_cmd_t){ .kind = STP_CMD_MOVE_ABS, .pos_stp = 0,
+                                .speed_sps = d->cfg.speed_sps, .acc_sps2 = d->cfg.acc_sps2 };
+    if (stepper_queue_push_n(m, cmd, n, seq) == 0) return 0;
+
+    deposit_item_t *it = &d->cur;
+    it->out_seq = seq[0];
+    it->back_seq = seq[n - 1u];
+    d->fly[(d->fly_head + d->fly_n) % DEPOSIT_INFLIGHT] = *it;
+    d->fly_n++;
+    return 1;
+}
+
+// Averaged: post the stroke and hand the scale over to DISARMED until the
+// item is off it. With no free slot the item is held and deposit_poll()
+// posts it once a stroke retires; the scale stays disarmed meanwhile, so
+// the same item is never weighed twice.
+static void weighed(deposit_t *d, stepper_motor *m, uint64_t t_ns, uint64_t real_ns){
+    deposit_item_t *it = &d->cur;
+    it->avg_kg = (float)(d->sum_kg / (double)sample_count(d));
+    it->sd_kg = (float)d->st.sd_kg;
+    it->t_weighed = t_ns;
+    it->t_real_ns = real_ns;
+    it->item = ++d->item;
+
+    d->phase = DEP_DISARMED;
+    d->rearm_item = it->item;
+    d->rearm_after_ns = 0;
+    d->rearm_seen = 0;
+
+    d->held = (uint8_t)!post(d, m);
+    if (d->held) d->stats.held++;
+}
+
+void deposit_feed(deposit_t *d, stepper_motor *m, const scale_sample_t *s, uint64_t real_ns){
+    if (!d || !m || !s) return;
+    d->seq = s->seq;
+
+    switch (d->phase) {
+    case DEP_DISARMED:
+        // The forward stroke has pushed the item off. The first conversion
+        // after it may have integrated part of the push; the next one is
+        // clean, and whatever it weighs is the next item.
+        if (!d->rearm_after_ns || s->t_ns <= d->rearm_after_ns) break;
+        if (++d->rearm_seen < 2u) break;
+        if (d->fly_n) d->stats.rearms_in_stroke++;
+        d->phase = DEP_ARMED;
+        // fall through - this conversion may already trigger
+    case DEP_ARMED:
+        if (s->kg <= d->cfg.trig_kg) break;
+        memset(&d->cur, 0, sizeof(d->cur));
+        d->cur.t_trig = s->t_ns;
+        settle_init(&d->st, &d->cfg.settle);
+        (void)settle_push(&d->st, s->kg, s->t_ns);
+        d->phase = DEP_SETTLING;
+        break;
+
+    case DEP_SETTLING: {
+        uint32_t dt_ms = ms_between(d->cur.t_trig, s->t_ns);
+        if (!settle_push(&d->st, s->kg, s->t_ns)) {
+            if (dt_ms < d->st.cfg.max_ms) break;
+            fprintf(stderr, "settle: not stable after %u ms (sd=%.4f kg, slope=%.4f kg/s), skipped\n",
+                    d->st.cfg.max_ms, d->st.sd_kg, d->st.slope_kg_s);
+            d->stats.skipped++;
+            d->phase = DEP_ARMED;
+            break;
+        }
+        if (d->st.mean_kg < (double)d->cfg.trig_kg) {
+            d->stats.skipped++;
+            d->phase = DEP_ARMED;
+            break;
+        }
+        d->cur.settle_ms = dt_ms;
+        d->cur.t_stable = s->t_ns;
+
+        // Average sample_count conversions. The settled window already
+        // counts towards it, so WEIGHING only takes the remainder (if any),
+        // each a distinct ADC reading from the ring.
+        uint32_t n = sample_count(d);
+        d->got = (d->st.n < n) ? d->st.n : n;
+        d->sum_kg = 0.0;
+        for (uint32_t i = 0; i < d->got; i++) {
+            d->sum_kg += (double)d->st.kg[(d->st.pos + d->st.cfg.window - 1u - i) % d->st.cfg.window];
+        }
+        if (d->got < n) d->phase = DEP_WEIGHING;
+        else weighed(d, m, s->t_ns, real_ns);
+        break;
+    }
+
+    case DEP_WEIGHING:
+        d->sum_kg += (double)s->kg;
+        if (++d->got >= sample_count(d)) weighed(d, m, s->t_ns, real_ns);
+        break;
+    }
+}
+
+static void stage(deposit_t *d, deposit_stage_id_t id, uint32_t ms){
+    d->stats.stage[id].sum_ms += ms;
+    if (ms > d->stats.stage[id].max_ms) d->stats.stage[id].max_ms = ms;
+}
+
+static void retire(deposit_t *d, deposit_item_t *it){
+    uint32_t cycle_ms = ms_between(it->t_trig, it->t_done);
+    stage(d, DEP_STAGE_SETTLE, it->settle_ms);
+    stage(d, DEP_STAGE_WEIGH, ms_between(it->t_stable, it->t_weighed));
+    stage(d, DEP_STAGE_WAIT, ms_between(it->t_weighed, it->t_start));
+    stage(d, DEP_STAGE_OUT, ms_between(it->t_start, it->t_out));
+    stage(d, DEP_STAGE_BACK, ms_between(it->t_out, it->t_done));
+    stage(d, DEP_STAGE_CYCLE, cycle_ms);
+    d->done_ns[d->stats.items % DEPOSIT_RATE_ITEMS] = it->t_done;
+    d->stats.items++;
+
+    // logged after the stroke so the record carries its timing; the write
+    // itself happens on the logger thread
+    event_log_item_t rec = {
+        .t_real_ns = it->t_real_ns,
+        .item = it->item,
+        .avg_kg = it->avg_kg,
+        .sd_kg = it->sd_kg,
+        .samples = sample_count(d),
+        .settle_ms = it->settle_ms,
+        .weigh_ms = ms_between(it->t_stable, it->t_weighed),
+        .stroke_ms = ms_between(it->t_weighed, it->t_done),
+        .cycle_ms = cycle_ms,
+    };
+    if (event_log_item(&rec) == -1) {
+        fprintf(stderr, "log: queue full, item %u not logged (%u dropped)\n", rec.item, event_log_dropped());
+    }
+    if (!d->cfg.quiet) {
+        fprintf(stderr, "item %u: avg=%.6f kg settle=%u ms cycle=%u ms | %.1f items/min\n",
+                rec.item, (double)rec.avg_kg, rec.settle_ms, cycle_ms, deposit_rate_per_min(d));
+    }
+}
+
+void deposit_poll(deposit_t *d, stepper_motor *m, uint64_t now_ns){
+    if (!d || !m || (d->fly_n == 0 && !d->held)) return;
+
+    stepper_status_t st;
+    stepper_get_status(m, &st);
+    if (st.state == STP_FAULT) {
+        fprintf(stderr, "deposit: stepper fault, %u strokes dropped\n", d->fly_n + d->held);
+        d->fly_n = 0;
+        d->held = 0;
+        if (!d->rearm_after_ns) d->rearm_after_ns = now_ns;
+        return;
+    }
+
+    // strokes finish in the order they were posted
+    while (d->fly_n) {
+        deposit_item_t *it = &d->fly[d->fly_head];
+        if (!it->t_out) {
+            if (!stepper_seq_done(m, it->out_seq)) break;
+            it->t_start = (d->last_done_ns > it->t_weighed) ? d->last_done_ns : it->t_weighed;
+            it->t_out = now_ns;
+            if (it->item == d->rearm_item && !d->rearm_after_ns) d->rearm_after_ns = now_ns;
+        }
+        if (!stepper_seq_done(m, it->back_seq)) break;
+        it->t_done = now_ns;
+        d->last_done_ns = now_ns;
+        retire(d, it);
+        d->fly_head = (d->fly_head + 1u) % DEPOSIT_INFLIGHT;
+        d->fly_n--;
+    }
+    if (d->held && post(d, m)) d->held = 0;
+}
+
+uint32_t deposit_wait_seq(const deposit_t *d){
+    if (!d || d->fly_n == 0) return 0;
+    const deposit_item_t *it = &d->fly[d->fly_head];
+    return it->t_out ? it->back_seq : it->out_seq;
+}
+
+int deposit_idle(const deposit_t *d){
+    return d && d->phase == DEP_ARMED && d->fly_n == 0;
+}
+
+double deposit_rate_per_min(const deposit_t *d){
+    if (!d || d->stats.items < 2) return 0.0;
+    uint64_t n = (d->stats.items < DEPOSIT_RATE_ITEMS) ? d->stats.items : DEPOSIT_RATE_ITEMS;
+    uint64_t newest = d->done_ns[(d->stats.items - 1u) % DEPOSIT_RATE_ITEMS];
+    uint64_t oldest = d->done_ns[(d->stats.items - n) % DEPOSIT_RATE_ITEMS];
+    if (newest <= oldest) return 0.0;
+    return (double)(n - 1u) * 60e9 / (double)(newest - oldest);
+}
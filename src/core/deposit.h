@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+#include "settle.h"
+#include "scale_ring.h"
+#include "stepper_driver.h"
+
+/*
+    Deposit cycle as a pipeline. The control loop never blocks on an item:
+    it feeds every conversion to deposit_feed() and calls deposit_poll()
+    whenever it wakes, and the two sides move on independently.
+
+    Scale side, one item at a time:
+        ARMED -> SETTLING -> WEIGHING -> DISARMED -> ARMED
+    Once weighed, the whole stroke (out, dwell, back) is posted to the
+    stepper mailbox. The scale re-arms with the second conversion after the
+    forward stroke is done (the first may still see the push), i.e. during
+    the return stroke; the next item then settles and weighs while the arm
+    is still on its way back, and its stroke queues behind the current one.
+    The log record is queued once the arm is back, with the stroke timing.
+
+    Motion side: up to DEPOSIT_INFLIGHT strokes, completed in order. An
+    item weighed while there is no room for its stroke (all in-flight slots
+    or the stepper mailbox taken) is held on the scale, still DISARMED, and
+    posted as soon as a stroke retires.
+*/
+#define DEPOSIT_INFLIGHT    4u      // strokes posted and not yet back at 0
+#define DEPOSIT_RATE_ITEMS  16u     // items/min over the last this many items
+
+typedef enum {
+    DEP_ARMED = 0,
+    DEP_SETTLING,
+    DEP_WEIGHING,
+    DEP_DISARMED,               // item on its way off the scale
+} deposit_phase_t;
+
+typedef struct deposit_cfg {
+    float    trig_kg;
+    uint32_t sample_count;      // conversions averaged per item
+    settle_cfg_t settle;
+    int32_t  move_stp;
+    uint32_t speed_sps;
+    uint32_t acc_sps2;
+    uint32_t dwell_ms;
+    uint8_t  quiet;             // no per-item line on stderr
+} deposit_cfg_t;
+
+// One item from trigger until the arm is back at 0 (monotonic ns).
+typedef struct deposit_item {
+    uint32_t item;
+    float    avg_kg;
+    float    sd_kg;
+    uint32_t settle_ms;
+    uint64_t t_real_ns;         // CLOCK_REALTIME when weighed
+    uint64_t t_trig, t_stable, t_weighed, t_start, t_out, t_done;
+    uint32_t out_seq, back_seq;
+} deposit_item_t;
+
+// Per-stage latency in ms
+typedef struct deposit_stage {
+    uint64_t sum_ms;
+    uint32_t max_ms;
+} deposit_stage_t;
+
+typedef enum {
+    DEP_STAGE_SETTLE = 0,       // trigger -> stable
+    DEP_STAGE_WEIGH,            // stable -> average done
+    DEP_STAGE_WAIT,             // weighed -> stroke starts (arm still busy with the last one)
+    DEP_STAGE_OUT,              // forward stroke
+    DEP_STAGE_BACK,             // dwell + return stroke
+    DEP_STAGE_CYCLE,            // trigger -> back at 0
+    DEP_STAGES
+} deposit_stage_id_t;
+
+typedef struct deposit_stats {
+    uint64_t items;             // strokes completed
+    uint64_t skipped;           // triggers that never gave a stable weight
+    uint64_t rearms_in_stroke;  // re-armed while the arm was still returning
+    uint64_t held;              // weighed items that had to wait for a stroke slot
+    deposit_stage_t stage[DEP_STAGES];
+} deposit_stats_t;
+
+typedef struct deposit {
+    deposit_cfg_t cfg;
+    deposit_phase_t phase;
+    uint32_t seq;               // last conversion consumed
+
+    // scale side
+    settle_t st;
+    deposit_item_t cur;
+    double   sum_kg;
+    uint32_t got;
+    uint32_t item;              // running item number
+    uint32_t rearm_item;        // DISARMED: the item leaving the scale
+    uint64_t rearm_after_ns;    // DISARMED: its forward stroke was done by then, 0 = not yet
+    uint32_t rearm_seen;        // DISARMED: conversions since then
+    uint8_t  held;              // DISARMED: cur is weighed, its stroke not posted yet
+
+    // motion side: ring of posted strokes, oldest at head
+    deposit_item_t fly[DEPOSIT_INFLIGHT];
+    uint32_t fly_head, fly_n;
+    uint64_t last_done_ns;      // when the arm last got back to 0
+
+    uint64_t done_ns[DEPOSIT_RATE_ITEMS];
+    deposit_stats_t stats;
+} deposit_t;
+
+void deposit_init(deposit_t *d, const deposit_cfg_t *cfg, uint32_t ring_seq);
+
+// New settings apply from the next trigger; strokes already posted keep theirs.
+void deposit_set_cfg(deposit_t *d, const deposit_cfg_t *cfg);
+
+// Feed one conversion (in ring order). May post a stroke to m.
+void deposit_feed(deposit_t *d, stepper_motor *m, const scale_sample_t *s, uint64_t real_ns);
+
+// Retire finished strokes. now_ns is when the caller woke for them.
+void deposit_poll(deposit_t *d, stepper_motor *m, uint64_t now_ns);
+
+// Motion command the control loop should wait on, 0 = none in flight.
+uint32_t deposit_wait_seq(const deposit_t *d);
+
+// 1 when no item is anywhere in the pipeline (zero tracking may run).
+int  deposit_idle(const deposit_t *d);
+
+// Items per minute over the last DEPOSIT_RATE_ITEMS strokes, 0 until two.
+double deposit_rate_per_min(const deposit_t *d);
@@ -0,0 +1,57 @@
+#include "settle.h"
+
+#include <math.h>
+#include <string.h>
+
+void settle_init(settle_t *s, const settle_cfg_t *cfg){
+    if (!s || !cfg) return;
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (s->cfg.window < 2u) s->cfg.window = 2u;
+    if (s->cfg.window > SETTLE_MAX_WIN) s->cfg.window = SETTLE_MAX_WIN;
+}
+
+void settle_reset(settle_t *s){
+    if (!s) return;
+    s->pos = 0;
+    s->n = 0;
+    s->mean_kg = 0.0;
+    s->sd_kg = 0.0;
+    s->slope_kg_s = 0.0;
+}
+
+int settle_push(settle_t *s, float kg, uint64_t t_ns){
+    if (!s) return 0;
+    uint32_t w = s->cfg.window;
+
+    s->kg[s->pos] = kg;
+    s->t_ns[s->pos] = t_ns;
+    s->pos = (s->pos + 1u) % w;
+    if (s->n < w) s->n++;
+
+    // Two passes over at most 64 samples: cheap at ADC rates and free of the
+    // cancellation a running sum-of-squares would suffer around a large mean.
+    uint32_t n = s->n;
+    uint64_t t0 = s->t_ns[(s->pos + w - n) % w];
+    double sx = 0.0, st = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        sx += (double)s->kg[i];
+        st += (double)(s->t_ns[i] - t0) * 1e-9;
+    }
+    double mx = sx / (double)n, mt = st / (double)n;
+
+    double sxx = 0.0, stt = 0.0, stx = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double dx = (double)s->kg[i] - mx;
+        double dt = (double)(s->t_ns[i] - t0) * 1e-9 - mt;
+        sxx += dx * dx;
+        stt += dt * dt;
+        stx += dt * dx;
+    }
+    s->mean_kg = mx;
+    s->sd_kg = sqrt(sxx / (double)n);
+    s->slope_kg_s = (stt > 0.0) ? stx / stt : 0.0;
+
+    if (n < w) return 0;
+    return s->sd_kg <= (double)s->cfg.band_kg && fabs(s->slope_kg_s) <= (double)s->cfg.slope_kg_s;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+/*
+    Streaming settle detector for the scale. Keeps the last `window`
+    samples and calls the signal stable once the window is full and both
+        stddev <= band_kg   and   |slope| <= slope_kg_s
+    (slope is the least-squares fit over the window). Callers impose the
+    hard maximum wait themselves; see deposit_feed() in deposit.c.
+*/
+#define SETTLE_MAX_WIN 64u
+
+typedef struct settle_cfg {
+    uint32_t window;            // samples, 2..SETTLE_MAX_WIN
+    float    band_kg;           // max stddev over the window
+    float    slope_kg_s;        // max |drift|
+    uint32_t max_ms;            // give up after this long
+} settle_cfg_t;
+
+typedef struct settle {
+    settle_cfg_t cfg;
+    float    kg[SETTLE_MAX_WIN];
+    uint64_t t_ns[SETTLE_MAX_WIN];
+    uint32_t pos, n;
+
+    // results of the last settle_push()
+    double   mean_kg;
+    double   sd_kg;
+    double   slope_kg_s;
+} settle_t;
+
+void settle_init(settle_t *s, const settle_cfg_t *cfg);
+void settle_reset(settle_t *s);
+
+// Add one sample. Returns 1 if the window is now stable, else 0.
+int  settle_push(settle_t *s, float kg, uint64_t t_ns);
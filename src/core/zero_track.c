@@ -0,0 +1,57 @@
+#include "zero_track.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MAX_STEP_DT_NS  1000000000ull   // a long gap does not buy a big jump
+
+void zero_track_init(zero_track_t *z, const zero_track_cfg_t *cfg, int32_t tare_cts, float counts_per_kg){
+    if (!z || !cfg) return;
+    memset(z, 0, sizeof(*z));
+    z->cfg = *cfg;
+    z->counts_per_kg = counts_per_kg;
+    z->tare_cts = (double)tare_cts;
+    z->ref_cts = (double)tare_cts;
+    settle_init(&z->st, &cfg->settle);
+}
+
+void zero_track_freeze(zero_track_t *z, uint64_t t_ns){
+    if (!z) return;
+    uint64_t until = t_ns + (uint64_t)z->cfg.hold_ms * 1000000u;
+    if (until > z->hold_until_ns) z->hold_until_ns = until;
+    settle_reset(&z->st);
+    z->last_adj_ns = 0;
+}
+
+int32_t zero_track_tare(const zero_track_t *z){
+    return z ? (int32_t)lround(z->tare_cts) : 0;
+}
+
+int zero_track_push(zero_track_t *z, int32_t cts, uint64_t t_ns){
+    if (!z || z->counts_per_kg == 0.0f) return 0;
+
+    float kg = (float)(((double)cts - z->tare_cts) / (double)z->counts_per_kg);
+    if (fabsf(kg) > z->cfg.band_kg) {
+        zero_track_freeze(z, t_ns);
+        return 0;
+    }
+    if (t_ns < z->hold_until_ns) return 0;
+    // The window holds readings against ref_cts, not the live tare: samples
+    // taken before an adjustment must not carry the old offset into the next.
+    float ref_kg = (float)(((double)cts - z->ref_cts) / (double)z->counts_per_kg);
+    if (!settle_push(&z->st, ref_kg, t_ns)) return 0;
+
+    // stable and empty: slew toward the window mean
+    double err = z->st.mean_kg * (double)z->counts_per_kg + z->ref_cts - z->tare_cts;
+    uint64_t dt = z->last_adj_ns ? t_ns - z->last_adj_ns : 0u;
+    if (dt > MAX_STEP_DT_NS) dt = MAX_STEP_DT_NS;
+    z->last_adj_ns = t_ns;
+
+    double max_step = fabs((double)z->cfg.rate_kg_s * (double)z->counts_per_kg) * (double)dt * 1e-9;
+    if (err > max_step) err = max_step;
+    if (err < -max_step) err = -max_step;
+
+    int32_t before = zero_track_tare(z);
+    z->tare_cts += err;
+    return zero_track_tare(z) != before;
+}
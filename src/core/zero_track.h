@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include "settle.h"
+
+/*
+    Zero tracking. Follows slow drift of the empty-scale reading (temperature,
+    creep) by nudging the tare toward the mean of stable windows whose weight
+    is within band_kg of zero. The tare moves at most rate_kg_s, and tracking
+    freezes for hold_ms after anything heavier than the band, or after an
+    explicit zero_track_freeze(), so items are never tared away.
+
+    Works on filtered counts, so it does not depend on the tare in use by
+    the HX711 thread.
+*/
+typedef struct zero_track_cfg {
+    float    band_kg;           // |w| below this counts as empty
+    float    rate_kg_s;         // max tare slew
+    uint32_t hold_ms;           // freeze after an event
+    settle_cfg_t settle;        // what counts as stable
+} zero_track_cfg_t;
+
+typedef struct zero_track {
+    zero_track_cfg_t cfg;
+    float    counts_per_kg;
+    double   tare_cts;          // live tare, sub-count precision
+    double   ref_cts;           // fixed zero of the settle window, so moving the tare does not skew it
+    settle_t st;
+    uint64_t hold_until_ns;
+    uint64_t last_adj_ns;
+} zero_track_t;
+
+void    zero_track_init(zero_track_t *z, const zero_track_cfg_t *cfg, int32_t tare_cts, float counts_per_kg);
+
+// Feed one filtered conversion. Returns 1 if the integer tare changed.
+int     zero_track_push(zero_track_t *z, int32_t cts, uint64_t t_ns);
+
+// An item is being handled: stop tracking until hold_ms after t_ns.
+void    zero_track_freeze(zero_track_t *z, uint64_t t_ns);
+
+int32_t zero_track_tare(const zero_track_t *z);
@@ -0,0 +1,8 @@
+// File: src/hardware/gpio_backend.c
+#include "gpio_backend.h"
+
+const gpio_backend_t *gpio_active = 0;
+
+void gpio_set_backend(const gpio_backend_t *backend){
+    gpio_active = backend;
+}
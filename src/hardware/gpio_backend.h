@@ -0,0 +1,101 @@
+// File: src/hardware/gpio_backend.h
+#pragma once
+#include <stdint.h>
+
+/*
+    Pluggable GPIO backend.
+
+    The drivers never call libgpiod directly; they go through the gpio_*
+    wrappers below, which dispatch to whichever backend is active. Lines and
+    chips are opaque handles owned by the backend.
+
+    An edge line is an input requested for falling-edge events: it can be
+    read like any input, and wait_edge() blocks until the next falling edge.
+
+    A group is several lines of one direction requested together. All lines
+    of a group are written or read with a single call (one ioctl on
+    libgpiod); bit i of the value word is the i-th offset of the request.
+
+    The backend also owns the time source, so a simulated backend can run the
+    drivers on a virtual clock (see gpio_sim.h).
+*/
+typedef struct gpio_backend {
+    const char *name;
+
+    void *(*chip_open)(const char *path);
+    void  (*chip_close)(void *chip);
+
+    void *(*request_output)(void *chip, unsigned offset, const char *consumer, int value);
+    void *(*request_input)(void *chip, unsigned offset, const char *consumer);
+    void  (*release)(void *line);
+
+    int   (*set_value)(void *line, int value);
+    int   (*get_value)(void *line);
+
+    void *(*request_falling_edge)(void *chip, unsigned offset, const char *consumer);
+    // 1 = edge seen (*ts_ns = kernel timestamp, CLOCK_MONOTONIC), 0 = timeout, <0 = error
+    int   (*wait_edge)(void *line, uint64_t timeout_ns, uint64_t *ts_ns);
+    // drop edges that are already queued
+    int   (*flush_edges)(void *line);
+
+    void *(*request_output_group)(void *chip, const unsigned *offsets, unsigned n,
+                                  const char *consumer, uint32_t values);
+    void *(*request_input_group)(void *chip, const unsigned *offsets, unsigned n,
+                                 const char *consumer);
+    void  (*release_group)(void *group);
+
+    int   (*set_group)(void *group, uint32_t values);
+    int   (*get_group)(void *group, uint32_t *values);
+
+    uint64_t (*now_ns)(void);       // monotonic
+    void     (*sleep_ns)(uint64_t ns);
+} gpio_backend_t;
+
+extern const gpio_backend_t gpio_libgpiod_backend;
+
+extern const gpio_backend_t *gpio_active;
+
+// Select the backend used by all drivers. Must be called before any *_init().
+void gpio_set_backend(const gpio_backend_t *backend);
+
+static inline void *gpio_chip_open(const char *path){
+    return gpio_active ? gpio_active->chip_open(path) : 0;
+}
+static inline void gpio_chip_close(void *chip){ gpio_active->chip_close(chip); }
+
+static inline void *gpio_request_output(void *chip, unsigned offset, const char *consumer, int value){
+    return gpio_active->request_output(chip, offset, consumer, value);
+}
+static inline void *gpio_request_input(void *chip, unsigned offset, const char *consumer){
+    return gpio_active->request_input(chip, offset, consumer);
+}
+static inline void gpio_release(void *line){ gpio_active->release(line); }
+
+static inline int gpio_set_value(void *line, int value){ return gpio_active->set_value(line, value); }
+static inline int gpio_get_value(void *line){ return gpio_active->get_value(line); }
+
+static inline void *gpio_request_falling_edge(void *chip, unsigned offset, const char *consumer){
+    return gpio_active->request_falling_edge(chip, offset, consumer);
+}
+static inline int gpio_wait_edge(void *line, uint64_t timeout_ns, uint64_t *ts_ns){
+    return gpio_active->wait_edge(line, timeout_ns, ts_ns);
+}
+static inline int gpio_flush_edges(void *line){ return gpio_active->flush_edges(line); }
+
+#define GPIO_GROUP_MAX  32u
+
+static inline void *gpio_request_output_group(void *chip, const unsigned *offsets, unsigned n,
+                                              const char *consumer, uint32_t values){
+    return gpio_active->request_output_group(chip, offsets, n, consumer, values);
+}
+static inline void *gpio_request_input_group(void *chip, const unsigned *offsets, unsigned n,
+                                             const char *consumer){
+    return gpio_active->request_input_group(chip, offsets, n, consumer);
+}
+static inline void gpio_release_group(void *group){ gpio_active->release_group(group); }
+
+static inline int gpio_set_group(void *group, uint32_t values){ return gpio_active->set_group(group, values); }
+static inline int gpio_get_group(void *group, uint32_t *values){ return gpio_active->get_group(group, values); }
+
+static inline uint64_t gpio_now_ns(void){ return gpio_active->now_ns(); }
+static inline void gpio_sleep_ns(uint64_t ns){ gpio_active->sleep_ns(ns); }
@@ -0,0 +1,165 @@
+// File: src/hardware/gpio_libgpiod.c
+#include "gpio_backend.h"
+
+#include <gpiod.h>
+#include <time.h>
+#include <stdlib.h>
+
+static void *lg_chip_open(const char *path){
+    return gpiod_chip_open(path);
+}
+
+static void lg_chip_close(void *chip){
+    gpiod_chip_close((struct gpiod_chip*)chip);
+}
+
+static void *lg_request_output(void *chip, unsigned offset, const char *consumer, int value){
+    struct gpiod_line *l = gpiod_chip_get_line((struct gpiod_chip*)chip, offset);
+    if (!l) return 0;
+    if (gpiod_line_request_output(l, consumer, value) < 0) return 0;
+    return l;
+}
+
+static void *lg_request_input(void *chip, unsigned offset, const char *consumer){
+    struct gpiod_line *l = gpiod_chip_get_line((struct gpiod_chip*)chip, offset);
+    if (!l) return 0;
+    if (gpiod_line_request_input(l, consumer) < 0) return 0;
+    return l;
+}
+
+static void lg_release(void *line){
+    gpiod_line_release((struct gpiod_line*)line);
+}
+
+static int lg_set_value(void *line, int value){
+    return gpiod_line_set_value((struct gpiod_line*)line, value);
+}
+
+static int lg_get_value(void *line){
+    return gpiod_line_get_value((struct gpiod_line*)line);
+}
+
+static void *lg_request_falling_edge(void *chip, unsigned offset, const char *consumer){
+    struct gpiod_line *l = gpiod_chip_get_line((struct gpiod_chip*)chip, offset);
+    if (!l) return 0;
+    if (gpiod_line_request_falling_edge_events(l, consumer) < 0) return 0;
+    return l;
+}
+
+// Event timestamps are CLOCK_MONOTONIC on any kernel >= 5.7.
+static int lg_wait_edge(void *line, uint64_t timeout_ns, uint64_t *ts_ns){
+    struct gpiod_line *l = (struct gpiod_line*)line;
+    struct timespec to = { .tv_sec = (time_t)(timeout_ns / 1000000000u), .tv_nsec = (long)(timeout_ns % 1000000000u) };
+    int rc = gpiod_line_event_wait(l, &to);
+    if (rc <= 0) return rc;
+
+    struct gpiod_line_event ev;
+    if (gpiod_line_event_read(l, &ev) < 0) return -1;
+    if (ts_ns) *ts_ns = (uint64_t)(int64_t)ev.ts.tv_sec * 1000000000u + (uint64_t)(int64_t)ev.ts.tv_nsec;
+    return 1;
+}
+
+static int lg_flush_edges(void *line){
+    struct gpiod_line *l = (struct gpiod_line*)line;
+    const struct timespec zero = { 0, 0 };
+    struct gpiod_line_event ev;
+    int n = 0;
+    while (gpiod_line_event_wait(l, &zero) == 1) {
+        if (gpiod_line_event_read(l, &ev) < 0) return -1;
+        n++;
+    }
+    return n;
+}
+
+typedef struct {
+    struct gpiod_line_bulk bulk;
+    unsigned n;
+} lg_group_t;
+
+static lg_group_t *lg_group_get(void *chip, const unsigned *offsets, unsigned n){
+    if (!chip || !offsets || n == 0 || n > GPIO_GROUP_MAX) return 0;
+    lg_group_t *grp = calloc(1, sizeof(*grp));
+    if (!grp) return 0;
+    gpiod_line_bulk_init(&grp->bulk);
+    for (unsigned i = 0; i < n; i++) {
+        struct gpiod_line *l = gpiod_chip_get_line((struct gpiod_chip*)chip, offsets[i]);
+        if (!l) { free(grp); return 0; }
+        gpiod_line_bulk_add(&grp->bulk, l);
+    }
+    grp->n = n;
+    return grp;
+}
+
+static void *lg_request_output_group(void *chip, const unsigned *offsets, unsigned n,
+                                     const char *consumer, uint32_t values){
+    lg_group_t *grp = lg_group_get(chip, offsets, n);
+    if (!grp) return 0;
+    int v[GPIO_GROUP_MAX];
+    for (unsigned i = 0; i < n; i++) v[i] = (int)((values >> i) & 1u);
+    if (gpiod_line_request_bulk_output(&grp->bulk, consumer, v) < 0) { free(grp); return 0; }
+    return grp;
+}
+
+static void *lg_request_input_group(void *chip, const unsigned *offsets, unsigned n,
+                                    const char *consumer){
+    lg_group_t *grp = lg_group_get(chip, offsets, n);
+    if (!grp) return 0;
+    if (gpiod_line_request_bulk_input(&grp->bulk, consumer) < 0) { free(grp); return 0; }
+    return grp;
+}
+
+static void lg_release_group(void *group){
+    lg_group_t *grp = (lg_group_t*)group;
+    if (!grp) return;
+    gpiod_line_release_bulk(&grp->bulk);
+    free(grp);
+}
+
+static int lg_set_group(void *group, uint32_t values){
+    lg_group_t *grp = (lg_group_t*)group;
+    int v[GPIO_GROUP_MAX];
+    for (unsigned i = 0; i < grp->n; i++) v[i] = (int)((values >> i) & 1u);
+    return gpiod_line_set_value_bulk(&grp->bulk, v);
+}
+
+static int lg_get_group(void *group, uint32_t *values){
+    lg_group_t *grp = (lg_group_t*)group;
+    int v[GPIO_GROUP_MAX];
+    if (gpiod_line_get_value_bulk(&grp->bulk, v) < 0) return -1;
+    uint32_t bits = 0;
+    for (unsigned i = 0; i < grp->n; i++) bits |= (uint32_t)(v[i] & 1) << i;
+    *values = bits;
+    return 0;
+}
+
+static uint64_t lg_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(int64_t)ts.tv_sec * 1000000000u + (uint64_t)(int64_t)ts.tv_nsec;
+}
+
+static void lg_sleep_ns(uint64_t ns){
+    struct timespec ts = { .tv_sec = (time_t)(ns / 1000000000u), .tv_nsec = (long)(ns % 1000000000u) };
+    nanosleep(&ts, 0);
+}
+
+const gpio_backend_t gpio_libgpiod_backend = {
+    .name           = "libgpiod",
+    .chip_open      = lg_chip_open,
+    .chip_close     = lg_chip_close,
+    .request_output = lg_request_output,
+    .request_input  = lg_request_input,
+    .release        = lg_release,
+    .set_value      = lg_set_value,
+    .get_value      = lg_get_value,
+    .request_falling_edge = lg_request_falling_edge,
+    .wait_edge      = lg_wait_edge,
+    .flush_edges    = lg_flush_edges,
+    .request_output_group = lg_request_output_group,
+    .request_input_group  = lg_request_input_group,
+    .release_group  = lg_release_group,
+    .set_group      = lg_set_group,
+    .get_group      = lg_get_group,
+    .now_ns         = lg_now_ns,
+    .sleep_ns       = lg_sleep_ns,
+};
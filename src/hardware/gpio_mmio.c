@@ -0,0 +1,325 @@
+// File: src/hardware/gpio_mmio.c
+#include "gpio_mmio.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// RP1 bank 0 layout inside the window
+#define IO_BANK_OFF     0x00000u    // GPIOn_STATUS at 8n, GPIOn_CTRL at 8n + 4
+#define RIO_OFF         0x10000u
+#define PADS_OFF        0x20000u    // VOLTAGE_SELECT, then GPIOn at 4 + 4n
+
+#define RIO_OUT         0x00u
+#define RIO_OE          0x04u
+#define RIO_SYNC_IN     0x0cu
+#define ALIAS_SET       0x2000u
+#define ALIAS_CLR       0x3000u
+
+#define CTRL_FUNCSEL    0x1fu
+#define FUNCSEL_RIO     5u
+#define PAD_OD          (1u << 7)   // output disable
+#define PAD_IE          (1u << 6)   // input enable
+
+#define MAX_CHIPS       4u
+#define MAX_HANDLES     16u
+
+typedef struct {
+    uint8_t used;
+    void   *fb_chip;
+} mmio_chip_t;
+
+// a line or a group; fb set = a fallback line (edge events)
+typedef struct {
+    uint8_t  used;
+    uint8_t  output;
+    uint8_t  n;
+    uint8_t  pin[GPIO_GROUP_MAX];
+    uint32_t mask;
+    void    *fb;
+} mmio_line_t;
+
+static struct {
+    volatile uint32_t *base;
+    size_t   len;
+    uint8_t  emulate;           // plain file: no set/clear aliases
+    const gpio_backend_t *fb;
+    uint32_t claimed;
+    mmio_chip_t chips[MAX_CHIPS];
+    mmio_line_t lines[MAX_HANDLES];
+} g;
+
+static inline volatile uint32_t *reg(uint32_t off){
+    return g.base + off / 4u;
+}
+
+static void rio_set(uint32_t r, uint32_t mask){
+    if (!mask) return;
+    if (g.emulate) *reg(RIO_OFF + r) |= mask;
+    else *reg(RIO_OFF + ALIAS_SET + r) = mask;
+}
+
+static void rio_clr(uint32_t r, uint32_t mask){
+    if (!mask) return;
+    if (g.emulate) *reg(RIO_OFF + r) &= ~mask;
+    else *reg(RIO_OFF + ALIAS_CLR + r) = mask;
+}
+
+// read back so the posted write has reached the pad
+static inline void rio_flush(void){
+    (void)*reg(RIO_OFF + RIO_OUT);
+}
+
+static uint32_t rio_in(void){
+    if (!g.emulate) return *reg(RIO_OFF + RIO_SYNC_IN);
+    uint32_t oe = *reg(RIO_OFF + RIO_OE);
+    return (*reg(RIO_OFF + RIO_SYNC_IN) & ~oe) | (*reg(RIO_OFF + RIO_OUT) & oe);
+}
+
+// Hand a pin to RIO. Level and direction are set before the function
+// select, so an output never glitches through the wrong level.
+static int pin_claim(unsigned pin, int output, int value){
+    if (pin >= GPIO_MMIO_PINS || ((g.claimed >> pin) & 1u)) return -1;
+    uint32_t bit = 1u << pin;
+
+    volatile uint32_t *pad = reg(PADS_OFF + 4u + 4u * pin);
+    *pad = (*pad & ~PAD_OD) | PAD_IE;
+    if (output) {
+        if (value) rio_set(RIO_OUT, bit);
+        else rio_clr(RIO_OUT, bit);
+        rio_set(RIO_OE, bit);
+    } else {
+        rio_clr(RIO_OE, bit);
+    }
+    volatile uint32_t *ctrl = reg(IO_BANK_OFF + 8u * pin + 4u);
+    *ctrl = (*ctrl & ~CTRL_FUNCSEL) | FUNCSEL_RIO;
+    rio_flush();
+
+    g.claimed |= bit;
+    return 0;
+}
+
+static void pin_release(unsigned pin){
+    rio_clr(RIO_OE, 1u << pin);
+    g.claimed &= ~(1u << pin);
+}
+
+static mmio_line_t *handle_get(void){
+    for (unsigned i = 0; i < MAX_HANDLES; i++) {
+        if (!g.lines[i].used) {
+            memset(&g.lines[i], 0, sizeof(g.lines[i]));
+            g.lines[i].used = 1;
+            return &g.lines[i];
+        }
+    }
+    return 0;
+}
+
+// ---- backend ops ----
+
+static void *mm_chip_open(const char *path){
+    if (!g.base) return 0;
+    for (unsigned i = 0; i < MAX_CHIPS; i++) {
+        mmio_chip_t *c = &g.chips[i];
+        if (c->used) continue;
+        c->used = 1;
+        c->fb_chip = g.fb ? g.fb->chip_open(path) : 0;
+        return c;
+    }
+    return 0;
+}
+
+static void mm_chip_close(void *chip){
+    mmio_chip_t *c = (mmio_chip_t*)chip;
+    if (!c) return;
+    if (c->fb_chip) g.fb->chip_close(c->fb_chip);
+    c->fb_chip = 0;
+    c->used = 0;
+}
+
+static void *mm_request_group(const unsigned *offsets, unsigned n, int output, uint32_t values){
+    if (!offsets || n == 0 || n > GPIO_GROUP_MAX) return 0;
+    mmio_line_t *l = handle_get();
+    if (!l) return 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (pin_claim(offsets[i], output, (int)((values >> i) & 1u)) < 0) {
+            while (i-- > 0) pin_release(l->pin[i]);
+            l->used = 0;
+            return 0;
+        }
+        l->pin[i] = (uint8_t)offsets[i];
+        l->mask |= 1u << offsets[i];
+    }
+    l->n = (uint8_t)n;
+    l->output = (uint8_t)(output ? 1 : 0);
+    return l;
+}
+
+static void *mm_request_output(void *chip, unsigned offset, const char *consumer, int value){
+    (void)chip; (void)consumer;
+    return mm_request_group(&offset, 1, 1, value ? 1u : 0u);
+}
+
+static void *mm_request_input(void *chip, unsigned offset, const char *consumer){
+    (void)chip; (void)consumer;
+    return mm_request_group(&offset, 1, 0, 0u);
+}
+
+static void mm_release_group(void *line){
+    mmio_line_t *l = (mmio_line_t*)line;
+    if (!l || !l->used) return;
+    if (l->fb) g.fb->release(l->fb);
+    else for (unsigned i = 0; i < l->n; i++) pin_release(l->pin[i]);
+    l->used = 0;
+}
+
+static int mm_set_value(void *line, int value){
+    mmio_line_t *l = (mmio_line_t*)line;
+    if (!l || !l->output) return -1;
+    if (value) rio_set(RIO_OUT, l->mask);
+    else rio_clr(RIO_OUT, l->mask);
+    rio_flush();
+    return 0;
+}
+
+static int mm_get_value(void *line){
+    mmio_line_t *l = (mmio_line_t*)line;
+    if (!l) return -1;
+    if (l->fb) return g.fb->get_value(l->fb);
+    return (int)((rio_in() >> l->pin[0]) & 1u);
+}
+
+static void *mm_request_falling_edge(void *chip, unsigned offset, const char *consumer){
+    mmio_chip_t *c = (mmio_chip_t*)chip;
+    if (!c || !c->fb_chip) return 0;
+    mmio_line_t *l = handle_get();
+    if (!l) return 0;
+    l->fb = g.fb->request_falling_edge(c->fb_chip, offset, consumer);
+    if (!l->fb) {
+        l->used = 0;
+        return 0;
+    }
+    l->n = 1;
+    l->pin[0] = (uint8_t)offset;
+    return l;
+}
+
+static int mm_wait_edge(void *line, uint64_t timeout_ns, uint64_t *ts_ns){
+    mmio_line_t *l = (mmio_line_t*)line;
+    if (!l || !l->fb) return -1;
+    return g.fb->wait_edge(l->fb, timeout_ns, ts_ns);
+}
+
+static int mm_flush_edges(void *line){
+    mmio_line_t *l = (mmio_line_t*)line;
+    if (!l || !l->fb) return -1;
+    return g.fb->flush_edges(l->fb);
+}
+
+static void *mm_request_output_group(void *chip, const unsigned *offsets, unsigned n,
+                                     const char *consumer, uint32_t values){
+    (void)chip; (void)consumer;
+    return mm_request_group(offsets, n, 1, values);
+}
+
+static void *mm_request_input_group(void *chip, const unsigned *offsets, unsigned n,
+                                    const char *consumer){
+    (void)chip; (void)consumer;
+    return mm_request_group(offsets, n, 0, 0u);
+}
+
+// one set store and one clear store, however many lines change
+static int mm_set_group(void *group, uint32_t values){
+    mmio_line_t *l = (mmio_line_t*)group;
+    if (!l || !l->output) return -1;
+    uint32_t set = 0, clr = 0;
+    for (unsigned i = 0; i < l->n; i++) {
+        if ((values >> i) & 1u) set |= 1u << l->pin[i];
+        else clr |= 1u << l->pin[i];
+    }
+    rio_set(RIO_OUT, set);
+    rio_clr(RIO_OUT, clr);
+    rio_flush();
+    return 0;
+}
+
+static int mm_get_group(void *group, uint32_t *values){
+    mmio_line_t *l = (mmio_line_t*)group;
+    if (!l || !values) return -1;
+    uint32_t in = rio_in(), bits = 0;
+    for (unsigned i = 0; i < l->n; i++) bits |= ((in >> l->pin[i]) & 1u) << i;
+    *values = bits;
+    return 0;
+}
+
+static uint64_t mm_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(int64_t)ts.tv_sec * 1000000000u + (uint64_t)(int64_t)ts.tv_nsec;
+}
+
+static void mm_sleep_ns(uint64_t ns){
+    struct timespec ts = { .tv_sec = (time_t)(ns / 1000000000u), .tv_nsec = (long)(ns % 1000000000u) };
+    nanosleep(&ts, 0);
+}
+
+int gpio_mmio_open(const char *path, const gpio_backend_t *fallback){
+    if (!path) { errno = EINVAL; return -1; }
+    gpio_mmio_close();
+
+    int fd = open(path, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat sb;
+    if (fstat(fd, &sb) < 0) { close(fd); return -1; }
+    int plain = S_ISREG(sb.st_mode);
+    if (plain && (uint64_t)sb.st_size < GPIO_MMIO_WINDOW_LEN) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *p = mmap(NULL, GPIO_MMIO_WINDOW_LEN, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);      // the mapping keeps its own reference
+    if (p == MAP_FAILED) { errno = err; return -1; }
+
+    memset(&g, 0, sizeof(g));
+    g.base = (volatile uint32_t*)p;
+    g.len = GPIO_MMIO_WINDOW_LEN;
+    g.emulate = (uint8_t)plain;
+    g.fb = fallback;
+    return 0;
+}
+
+void gpio_mmio_close(void){
+    if (!g.base) return;
+    for (unsigned i = 0; i < MAX_HANDLES; i++) mm_release_group(&g.lines[i]);
+    for (unsigned i = 0; i < MAX_CHIPS; i++) mm_chip_close(&g.chips[i]);
+    (void)munmap((void*)g.base, g.len);
+    g.base = 0;
+}
+
+const gpio_backend_t gpio_mmio_backend = {
+    .name           = "mmio",
+    .chip_open      = mm_chip_open,
+    .chip_close     = mm_chip_close,
+    .request_output = mm_request_output,
+    .request_input  = mm_request_input,
+    .release        = mm_release_group,
+    .set_value      = mm_set_value,
+    .get_value      = mm_get_value,
+    .request_falling_edge = mm_request_falling_edge,
+    .wait_edge      = mm_wait_edge,
+    .flush_edges    = mm_flush_edges,
+    .request_output_group = mm_request_output_group,
+    .request_input_group  = mm_request_input_group,
+    .release_group  = mm_release_group,
+    .set_group      = mm_set_group,
+    .get_group      = mm_get_group,
+    .now_ns         = mm_now_ns,
+    .sleep_ns       = mm_sleep_ns,
+};
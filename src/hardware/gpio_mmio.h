@@ -0,0 +1,33 @@
+// File: src/hardware/gpio_mmio.h
+#pragma once
+#include "gpio_backend.h"
+
+/*
+    Register-mapped GPIO backend for the Raspberry Pi 5 (RP1, bank 0).
+
+    Maps the bank's register window (/dev/gpiomem0: IO_BANK0, SYS_RIO0 and
+    PADS_BANK0 back to back) and drives lines with plain stores to the RIO
+    set / clear aliases, so a pin write is a store, not an ioctl. Each write
+    is read back once, which pushes the posted PCIe write out to the pin
+    before the caller goes on: the edge is on the wire when set_value()
+    returns, and back-to-back writes (HX711 SCK) cannot merge into a pulse
+    shorter than that round trip.
+
+    There are no interrupts on this path. Falling-edge requests (HX711 DOUT)
+    go to the fallback backend given to gpio_mmio_open(), on the chip path
+    the driver asked for; without a fallback they fail and the drivers poll.
+
+    Pointing the path at a plain file of GPIO_MMIO_WINDOW_LEN bytes gives a
+    stand-in for the window on any Linux box: stores then update OUT / OE
+    directly (a file has no aliases) and inputs read back as SYNC_IN for
+    input pins and OUT for outputs.
+*/
+#define GPIO_MMIO_WINDOW_LEN    0x30000u
+#define GPIO_MMIO_PINS          28u         // bank 0: GPIO0..27 on the header
+
+extern const gpio_backend_t gpio_mmio_backend;
+
+// Map the window. Re-opening replaces the previous mapping (and forgets its
+// lines). Returns 0, or -1 with errno set; keep the current backend then.
+int  gpio_mmio_open(const char *path, const gpio_backend_t *fallback);
+void gpio_mmio_close(void);
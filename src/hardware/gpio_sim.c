@@ -0,0 +1,364 @@
+// File: src/hardware/gpio_sim.c
+#include "gpio_sim.h"
+
+#include <string.h>
+
+#define SIM_MAX_LINES       64u
+#define SIM_MAX_GROUPS      8u
+#define HX_BITS             24u
+#define HX_POWERDOWN_NS     60000u
+
+typedef struct {
+    unsigned offset;
+    uint8_t  requested;
+    uint8_t  is_output;
+    uint8_t  is_edge;
+    int      value;
+} sim_line_t;
+
+typedef struct {
+    uint8_t     used;
+    unsigned    n;
+    sim_line_t *lines[GPIO_GROUP_MAX];
+} sim_group_t;
+
+static struct {
+    gpio_sim_config_t cfg;
+    gpio_sim_stats_t  st;
+    uint64_t   now_ns;
+    sim_line_t lines[SIM_MAX_LINES];
+    sim_group_t groups[SIM_MAX_GROUPS];
+
+    // HX711 model
+    uint64_t hx_next_ready_ns;
+    uint32_t hx_pulses;             // rising edges in the current read
+    uint32_t hx_cur;                // 24-bit word being shifted out
+    size_t   hx_idx;
+    uint64_t hx_sck_rise_ns;
+    uint64_t hx_read_start_ns;
+    int      hx_dout_level;         // last level driven while clocking
+    uint8_t  hx_ready_seen;         // ready edge of this conversion delivered/flushed
+    uint32_t hx_evt_pending;        // falling edges caused by data bits
+    uint64_t hx_evt_ns;
+} sim;
+
+static void hx_poll(void){
+    // after the 25th pulse DOUT stays high until the next conversion is ready
+    if (sim.hx_pulses > HX_BITS && sim.now_ns >= sim.hx_next_ready_ns) {
+        sim.st.hx_last_pulses = sim.hx_pulses;
+        sim.hx_pulses = 0;
+    }
+}
+
+static int hx_dout(void){
+    hx_poll();
+    if (sim.hx_pulses == 0) return (sim.now_ns >= sim.hx_next_ready_ns) ? 0 : 1;
+    if (sim.hx_pulses <= HX_BITS) return (int)((sim.hx_cur >> (HX_BITS - sim.hx_pulses)) & 1u);
+    return 1;
+}
+
+static void hx_sck_edge(int level){
+    if (level) {
+        sim.hx_sck_rise_ns = sim.now_ns;
+        hx_poll();
+        if (sim.hx_pulses == 0) {
+            if (sim.now_ns < sim.hx_next_ready_ns) return; // clocking while busy: ignored
+            int32_t c = sim.cfg.hx_count_n ? sim.cfg.hx_counts[sim.hx_idx % sim.cfg.hx_count_n] : 0;
+            sim.hx_cur = (uint32_t)c & 0xFFFFFFu;
+            sim.hx_idx++;
+            sim.hx_read_start_ns = sim.now_ns;
+            sim.st.hx_ready_lat_ns += sim.now_ns - sim.hx_next_ready_ns;
+            sim.hx_dout_level = 0;  // ready
+        }
+        sim.hx_pulses++;
+        int lvl = (sim.hx_pulses <= HX_BITS) ? (int)((sim.hx_cur >> (HX_BITS - sim.hx_pulses)) & 1u) : 1;
+        if (sim.hx_dout_level == 1 && lvl == 0) {
+            sim.hx_evt_pending++;
+            sim.hx_evt_ns = sim.now_ns;
+        }
+        sim.hx_dout_level = lvl;
+        if (sim.hx_pulses == HX_BITS + 1u) {
+            sim.hx_ready_seen = 0;
+            sim.st.hx_conversions++;
+            sim.st.hx_read_window_ns = sim.now_ns - sim.hx_read_start_ns;
+            sim.hx_next_ready_ns = sim.now_ns + (uint64_t)sim.cfg.hx_conv_period_us * 1000u;
+        }
+    } else {
+        uint64_t high_ns = sim.now_ns - sim.hx_sck_rise_ns;
+        if (high_ns > sim.st.hx_sck_high_max_ns) sim.st.hx_sck_high_max_ns = high_ns;
+        if (high_ns > HX_POWERDOWN_NS) {
+            // chip powered down: the read is lost and a fresh conversion starts
+            sim.st.hx_sck_powerdowns++;
+            sim.hx_pulses = 0;
+            sim.hx_ready_seen = 0;
+            sim.hx_dout_level = 1;
+            sim.hx_next_ready_ns = sim.now_ns + (uint64_t)sim.cfg.hx_conv_period_us * 1000u;
+        }
+    }
+}
+
+static void step_edge(void){
+    int dir_level = sim.lines[sim.cfg.dir_line % SIM_MAX_LINES].value;
+    sim.st.pos_stp += (dir_level == (int)sim.cfg.dir_positive_level) ? +1 : -1;
+    sim.st.step_edges++;
+    sim.st.last_step_ns = sim.now_ns;
+}
+
+static int home_level(void){
+    int active = (sim.cfg.home_side < 0) ? (sim.st.pos_stp <= sim.cfg.home_pos_stp)
+                                         : (sim.st.pos_stp >= sim.cfg.home_pos_stp);
+    return active ? (int)sim.cfg.home_active_level : !sim.cfg.home_active_level;
+}
+
+// ---- backend ops ----
+
+static void *sim_chip_open(const char *path){
+    (void)path;
+    return &sim;
+}
+
+static void sim_chip_close(void *chip){
+    (void)chip;
+}
+
+static sim_line_t *sim_request(unsigned offset, int is_output, int value){
+    if (offset >= SIM_MAX_LINES) return 0;
+    sim_line_t *l = &sim.lines[offset];
+    if (l->requested) return 0;
+    l->offset = offset;
+    l->requested = 1;
+    l->is_edge = 0;
+    l->is_output = (uint8_t)is_output;
+    if (is_output) l->value = value;
+    return l;
+}
+
+static void *sim_request_output(void *chip, unsigned offset, const char *consumer, int value){
+    (void)chip; (void)consumer;
+    return sim_request(offset, 1, value);
+}
+
+static void *sim_request_input(void *chip, unsigned offset, const char *consumer){
+    (void)chip; (void)consumer;
+    return sim_request(offset, 0, 0);
+}
+
+static void sim_release(void *line){
+    sim_line_t *l = (sim_line_t*)line;
+    if (l) l->requested = 0;
+}
+
+static void sim_charge(void){
+    sim.now_ns += sim.cfg.op_cost_ns;
+    sim.st.ops++;
+}
+
+static void sim_write(sim_line_t *l, int value){
+    value = value ? 1 : 0;
+    int prev = l->value;
+    l->value = value;
+    if (prev == value) return;
+
+    if (l->offset == sim.cfg.step_line && value) step_edge();
+    if (l->offset == sim.cfg.sck_line) hx_sck_edge(value);
+}
+
+static int sim_read(const sim_line_t *l){
+    if (l->is_output) return l->value;
+    if (l->offset == sim.cfg.home_line) return home_level();
+    if (l->offset == sim.cfg.dout_line || ((sim.cfg.hx_dout_mirror >> l->offset) & 1u)) return hx_dout();
+    return l->value;
+}
+
+static int sim_set_value(void *line, int value){
+    sim_line_t *l = (sim_line_t*)line;
+    if (!l || !l->is_output) return -1;
+    sim_charge();
+    sim_write(l, value);
+    return 0;
+}
+
+static int sim_get_value(void *line){
+    sim_line_t *l = (sim_line_t*)line;
+    if (!l) return -1;
+    sim_charge();
+    return sim_read(l);
+}
+
+static void *sim_request_falling_edge(void *chip, unsigned offset, const char *consumer){
+    (void)chip; (void)consumer;
+    if (sim.cfg.no_edge_events) return 0;
+    sim_line_t *l = sim_request(offset, 0, 0);
+    if (l) l->is_edge = 1;
+    return l;
+}
+
+// The HX711 ready edge is pending once its conversion time has passed.
+static int hx_ready_pending(void){
+    return !sim.hx_ready_seen && sim.hx_pulses == 0 && sim.now_ns >= sim.hx_next_ready_ns;
+}
+
+static int sim_wait_edge(void *line, uint64_t timeout_ns, uint64_t *ts_ns){
+    sim_line_t *l = (sim_line_t*)line;
+    if (!l || !l->is_edge) return -1;
+    sim_charge();
+
+    if (l->offset != sim.cfg.dout_line) {
+        sim.now_ns += timeout_ns;
+        return 0;
+    }
+
+    hx_poll();
+    if (sim.hx_evt_pending) {
+        sim.hx_evt_pending--;
+        if (ts_ns) *ts_ns = sim.hx_evt_ns;
+        return 1;
+    }
+    if (!hx_ready_pending()) {
+        // sleep until the conversion completes, or time out
+        uint64_t ready = sim.hx_next_ready_ns;
+        int mid_read = sim.hx_pulses > 0 && sim.hx_pulses <= HX_BITS;
+        if (mid_read || sim.hx_ready_seen || ready > sim.now_ns + timeout_ns) {
+            sim.now_ns += timeout_ns;
+            hx_poll();
+            if (!hx_ready_pending()) return 0;
+        } else {
+            if (ready > sim.now_ns) sim.now_ns = ready;
+            hx_poll();
+        }
+    }
+    sim.hx_ready_seen = 1;
+    if (ts_ns) *ts_ns = sim.hx_next_ready_ns;
+    return 1;
+}
+
+static int sim_flush_edges(void *line){
+    sim_line_t *l = (sim_line_t*)line;
+    if (!l || !l->is_edge) return -1;
+    sim_charge();
+    if (l->offset != sim.cfg.dout_line) return 0;
+
+    hx_poll();
+    int n = (int)sim.hx_evt_pending;
+    sim.hx_evt_pending = 0;
+    if (hx_ready_pending()) {
+        sim.hx_ready_seen = 1;
+        n++;
+    }
+    return n;
+}
+
+static sim_group_t *sim_request_group(const unsigned *offsets, unsigned n, int is_output, uint32_t values){
+    if (!offsets || n == 0 || n > GPIO_GROUP_MAX) return 0;
+    sim_group_t *grp = 0;
+    for (unsigned i = 0; i < SIM_MAX_GROUPS; i++) {
+        if (!sim.groups[i].used) { grp = &sim.groups[i]; break; }
+    }
+    if (!grp) return 0;
+    for (unsigned i = 0; i < n; i++) {
+        grp->lines[i] = sim_request(offsets[i], is_output, (int)((values >> i) & 1u));
+        if (!grp->lines[i]) {
+            while (i-- > 0) grp->lines[i]->requested = 0;
+            return 0;
+        }
+    }
+    grp->n = n;
+    grp->used = 1;
+    return grp;
+}
+
+static void *sim_request_output_group(void *chip, const unsigned *offsets, unsigned n,
+                                      const char *consumer, uint32_t values){
+    (void)chip; (void)consumer;
+    return sim_request_group(offsets, n, 1, values);
+}
+
+static void *sim_request_input_group(void *chip, const unsigned *offsets, unsigned n,
+                                     const char *consumer){
+    (void)chip; (void)consumer;
+    return sim_request_group(offsets, n, 0, 0);
+}
+
+static void sim_release_group(void *group){
+    sim_group_t *grp = (sim_group_t*)group;
+    if (!grp) return;
+    for (unsigned i = 0; i < grp->n; i++) grp->lines[i]->requested = 0;
+    grp->used = 0;
+}
+
+// one call = one simulated ioctl, however many lines change
+static int sim_set_group(void *group, uint32_t values){
+    sim_group_t *grp = (sim_group_t*)group;
+    if (!grp || !grp->lines[0]->is_output) return -1;
+    sim_charge();
+    for (unsigned i = 0; i < grp->n; i++) sim_write(grp->lines[i], (int)((values >> i) & 1u));
+    return 0;
+}
+
+static int sim_get_group(void *group, uint32_t *values){
+    sim_group_t *grp = (sim_group_t*)group;
+    if (!grp || !values) return -1;
+    sim_charge();
+    uint32_t bits = 0;
+    for (unsigned i = 0; i < grp->n; i++) bits |= (uint32_t)(sim_read(grp->lines[i]) & 1) << i;
+    *values = bits;
+    return 0;
+}
+
+static uint64_t sim_now_ns(void){
+    return sim.now_ns;
+}
+
+static void sim_sleep_ns(uint64_t ns){
+    sim.now_ns += ns;
+}
+
+const gpio_backend_t gpio_sim_backend = {
+    .name           = "sim",
+    .chip_open      = sim_chip_open,
+    .chip_close     = sim_chip_close,
+    .request_output = sim_request_output,
+    .request_input  = sim_request_input,
+    .release        = sim_release,
+    .set_value      = sim_set_value,
+    .get_value      = sim_get_value,
+    .request_falling_edge = sim_request_falling_edge,
+    .wait_edge      = sim_wait_edge,
+    .flush_edges    = sim_flush_edges,
+    .request_output_group = sim_request_output_group,
+    .request_input_group  = sim_request_input_group,
+    .release_group  = sim_release_group,
+    .set_group      = sim_set_group,
+    .get_group      = sim_get_group,
+    .now_ns         = sim_now_ns,
+    .sleep_ns       = sim_sleep_ns,
+};
+
+// ---- control API ----
+
+void gpio_sim_reset(const gpio_sim_config_t *cfg){
+    memset(&sim, 0, sizeof(sim));
+    if (cfg) sim.cfg = *cfg;
+    // start well away from 0 so "0 means unset" timestamps in the drivers stay valid
+    sim.now_ns = 1000000000ull;
+    sim.hx_next_ready_ns = sim.now_ns + (uint64_t)sim.cfg.hx_conv_period_us * 1000u;
+    sim.hx_dout_level = 1;
+}
+
+uint64_t gpio_sim_now_ns(void){
+    return sim.now_ns;
+}
+
+void gpio_sim_advance_ns(uint64_t ns){
+    sim.now_ns += ns;
+}
+
+void gpio_sim_set_pos(int32_t pos_stp){
+    sim.st.pos_stp = pos_stp;
+}
+
+void gpio_sim_get_stats(gpio_sim_stats_t *out){
+    if (!out) return;
+    hx_poll();
+    *out = sim.st;
+}
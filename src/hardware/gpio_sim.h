@@ -0,0 +1,67 @@
+// File: src/hardware/gpio_sim.h
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "gpio_backend.h"
+
+/*
+    Simulated GPIO backend.
+
+    Runs on a virtual clock that only moves when the caller advances it, when a
+    driver sleeps, or by op_cost_ns per GPIO call. Models two devices:
+
+      - a stepper driver: rising edges on step_line move a simulated position
+        in the direction given by dir_line; home_line reads active once the
+        position reaches home_pos_stp from the home_side.
+      - an HX711: dout_line goes low every hx_conv_period_us, and SCK pulses
+        shift out the next scripted count MSB first.
+
+    Line numbers not listed in the config behave as plain latches.
+*/
+typedef struct gpio_sim_config {
+    uint32_t op_cost_ns;            // virtual time charged per set/get call
+    uint8_t  no_edge_events;        // refuse edge requests, like an old kernel
+
+    // ---- stepper model ----
+    unsigned step_line;
+    unsigned dir_line;
+    unsigned home_line;
+    uint8_t  dir_positive_level;    // DIR level that counts as +1
+    uint8_t  home_active_level;
+    int8_t   home_side;             // -1: active at pos <= home_pos_stp, +1: pos >= home_pos_stp
+    int32_t  home_pos_stp;
+
+    // ---- HX711 model ----
+    unsigned sck_line;
+    unsigned dout_line;
+    uint32_t hx_conv_period_us;     // 100000 for 10 SPS, 12500 for 80 SPS
+    const int32_t *hx_counts;       // scripted conversions, cycled
+    size_t   hx_count_n;
+    uint64_t hx_dout_mirror;        // more DOUT lines (bit = offset) showing the same
+                                    // chip, as identical HX711s on one SCK
+} gpio_sim_config_t;
+
+typedef struct gpio_sim_stats {
+    uint64_t ops;                   // set/get calls
+    uint64_t step_edges;            // rising edges on step_line
+    int32_t  pos_stp;               // simulated mechanical position
+    uint64_t last_step_ns;
+
+    uint64_t hx_conversions;        // completed 24-bit reads
+    uint32_t hx_last_pulses;        // SCK pulses in the last read (25..27)
+    uint64_t hx_sck_high_max_ns;    // longest SCK high time seen
+    uint64_t hx_sck_powerdowns;     // SCK held high > 60 us
+    uint64_t hx_read_window_ns;     // first SCK rise to the 25th pulse, last read
+    uint64_t hx_ready_lat_ns;       // DOUT ready to first SCK rise, summed over reads
+} gpio_sim_stats_t;
+
+extern const gpio_backend_t gpio_sim_backend;
+
+// Reset all lines, the virtual clock and the stats, then apply cfg.
+void gpio_sim_reset(const gpio_sim_config_t *cfg);
+
+uint64_t gpio_sim_now_ns(void);
+void     gpio_sim_advance_ns(uint64_t ns);
+
+void gpio_sim_set_pos(int32_t pos_stp);
+void gpio_sim_get_stats(gpio_sim_stats_t *out);
@@ -1,82 +1,217 @@
 #include "hx711_driver.h"
 
-#include <gpiod.h>
-#include <time.h>
+#include "gpio_backend.h"
 
-static void nsleep(long ns){
-    struct timespec ts = { .tv_sec = 0, .tv_nsec = ns };
-    nanosleep(&ts, 0);
-}
+#include <string.h>
+
+#define LATCH_UNKNOWN   0xffu
+#define RATE_MAX_GAP_NS 200000000u  // longer gaps are missed conversions, not the period
 
 static uint32_t now_ms(void){
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t ms = (uint64_t)(int64_t)ts.tv_sec * 1000u
-                + (uint64_t)(int64_t)ts.tv_nsec / 1000000u;
-    return (uint32_t)ms;
+    return (uint32_t)(gpio_now_ns() / 1000000u);
 }
 
-static int wait_ready(struct gpiod_line *dout, uint32_t timeout_ms){
+// Several channels: ready once every DOUT in the group reads low.
+static int wait_ready_group(hx711_t *h, uint32_t timeout_ms){
     uint32_t t0 = now_ms();
-    while (gpiod_line_get_value(dout) == 1) {
+    for (;;) {
+        uint32_t bits = 0;
+        h->io_calls++;
+        if (gpio_get_group(h->dout, &bits) < 0) return -1;
+        if (bits == 0) break;
         if ((uint32_t)(now_ms() - t0) > timeout_ms) return -1;
-        nsleep(500L * 1000L);
+        gpio_sleep_ns((uint64_t)HX711_POLL_US * 1000u);
     }
+    h->ready_ns = gpio_now_ns();
     return 0;
 }
 
-int hx711_init(hx711_t *h){
-    struct gpiod_chip *chip = gpiod_chip_open(h->gpiochip);
-    if (!chip) return -1;
+static int wait_ready(hx711_t *h, uint32_t timeout_ms){
+    if (hx711_channels(h) > 1u) return wait_ready_group(h, timeout_ms);
+    if (h->edge_events) {
+        // Edges queued while clocking out the previous word are stale. After
+        // the flush, DOUT low means we are already ready; otherwise the next
+        // falling edge is the ready signal. An edge that lands between the
+        // read and the wait stays queued, so it cannot be missed.
+        (void)gpio_flush_edges(h->dout);
+        h->io_calls += 2;
+        if (gpio_get_value(h->dout) == 0) {
+            h->ready_ns = gpio_now_ns();
+            return 0;
+        }
+        uint64_t ts = 0;
+        h->io_calls++;
+        if (gpio_wait_edge(h->dout, (uint64_t)timeout_ms * 1000000u, &ts) <= 0) return -1;
+        h->ready_ns = ts;
+        return 0;
+    }
 
-    struct gpiod_line *sck  = gpiod_chip_get_line(chip, h->sck_line);
-    struct gpiod_line *dout = gpiod_chip_get_line(chip, h->dout_line);
-    if (!sck || !dout) { gpiod_chip_close(chip); return -2; }
+    // fallback for backends without edge events: poll DOUT
+    uint32_t t0 = now_ms();
+    for (;;) {
+        h->io_calls++;
+        if (gpio_get_value(h->dout) != 1) break;
+        if ((uint32_t)(now_ms() - t0) > timeout_ms) return -1;
+        gpio_sleep_ns(500u * 1000u);
+    }
+    h->ready_ns = gpio_now_ns();
+    return 0;
+}
 
-    if (gpiod_line_request_output(sck, "hx711_sck", 0) < 0) { gpiod_chip_close(chip); return -3; }
-    if (gpiod_line_request_input(dout, "hx711_dout") < 0)   { gpiod_line_release(sck); gpiod_chip_close(chip); return -4; }
+int hx711_init(hx711_t *h){
+    if (h->channels > HX711_MAX_CHANNELS) return -2;
+    void *chip = gpio_chip_open(h->gpiochip);
+    if (!chip) return -1;
 
-    gpiod_line_set_value(sck, 0);
+    void *sck = gpio_request_output(chip, h->sck_line, "hx711_sck", 0);
+    if (!sck) { gpio_chip_close(chip); return -3; }
+
+    uint8_t edge = 0;
+    void *dout;
+    unsigned n = hx711_channels(h);
+    if (n > 1u) {
+        unsigned offsets[HX711_MAX_CHANNELS];
+        offsets[0] = h->dout_line;
+        for (unsigned i = 1; i < n; i++) offsets[i] = h->more[i - 1u].dout_line;
+        dout = gpio_request_input_group(chip, offsets, n, "hx711_dout");
+    } else {
+        // prefer falling-edge events on DOUT; plain input + polling if unsupported
+        edge = 1;
+        dout = gpio_request_falling_edge(chip, h->dout_line, "hx711_dout");
+        if (!dout) {
+            edge = 0;
+            dout = gpio_request_input(chip, h->dout_line, "hx711_dout");
+        }
+    }
+    if (!dout) { gpio_release(sck); gpio_chip_close(chip); return -4; }
 
     h->chip = chip;
     h->sck  = sck;
     h->dout = dout;
+    h->edge_events = edge;
+    h->ready_ns = 0;
+    h->io_calls = 0;
+    if (h->gain > HX711_GAIN_A64) h->gain = HX711_GAIN_A128;
+    h->latched = LATCH_UNKNOWN;
+    h->settle_left = 0;
+    h->period_ns = 0;
+    h->period_n = 0;
     return 0;
 }
 
 void hx711_close(hx711_t *h){
     if (!h) return;
-    if (h->dout) gpiod_line_release((struct gpiod_line*)h->dout);
-    if (h->sck)  gpiod_line_release((struct gpiod_line*)h->sck);
-    if (h->chip) gpiod_chip_close((struct gpiod_chip*)h->chip);
+    if (h->dout) {
+        if (hx711_channels(h) > 1u) gpio_release_group(h->dout);
+        else gpio_release(h->dout);
+    }
+    if (h->sck)  gpio_release(h->sck);
+    if (h->chip) gpio_chip_close(h->chip);
     h->chip = h->sck = h->dout = 0;
 }
 
 int hx711_read_raw(hx711_t *h, int32_t *raw_out){
-    struct gpiod_line *sck  = (struct gpiod_line*)h->sck;
-    struct gpiod_line *dout = (struct gpiod_line*)h->dout;
+    void *sck  = h->sck;
+    void *dout = h->dout;
 
     if (!sck || !dout || !raw_out) return -1;
-    if (wait_ready(dout, 2000) < 0) return -2;
+    uint64_t prev_ready = h->ready_ns;
+    if (wait_ready(h, 2000) < 0) return -2;
 
-    uint32_t raw = 0;
-
-    gpiod_line_set_value(sck, 0);
+    // SCK is requested low and always left low, so no idle write up front.
+    // Each bit is three calls: SCK high, SCK low, read DOUT. A set and a get
+    // cannot share one request, so that is the floor on the chardev API.
+    // With several channels the read is one group read: bit c is channel c.
+    unsigned n = hx711_channels(h);
+    uint32_t raw[HX711_MAX_CHANNELS] = {0};
 
     for (int i = 0; i < 24; i++) {
-        gpiod_line_set_value(sck, 1);
-        gpiod_line_set_value(sck, 0);
-        raw = (raw << 1) | (uint32_t)(gpiod_line_get_value(dout) & 1);
+        gpio_set_value(sck, 1);
+        gpio_set_value(sck, 0);
+        if (n == 1u) {
+            raw[0] = (raw[0] << 1) | (uint32_t)(gpio_get_value(dout) & 1);
+        } else {
+            uint32_t bits = 0;
+            (void)gpio_get_group(dout, &bits);
+            for (unsigned c = 0; c < n; c++) raw[c] = (raw[c] << 1) | ((bits >> c) & 1u);
+        }
     }
 
-    gpiod_line_set_value(sck, 1);
-    gpiod_line_set_value(sck, 0);
+    // 25..27th pulse: input and gain for the next conversion
+    unsigned pulses = 1u + (unsigned)h->gain;
+    for (unsigned i = 0; i < pulses; i++) {
+        gpio_set_value(sck, 1);
+        gpio_set_value(sck, 0);
+    }
+    h->io_calls += 24u * 3u + 2u * pulses;
+
+    // conversion period from back-to-back reads
+    if (prev_ready && h->ready_ns > prev_ready && h->ready_ns - prev_ready < RATE_MAX_GAP_NS) {
+        uint32_t dt = (uint32_t)(h->ready_ns - prev_ready);
+        if (h->period_n == 0) h->period_ns = dt;
+        else h->period_ns = (uint32_t)(((uint64_t)h->period_ns * 7u + dt) / 8u);
+        h->period_n++;
+    }
 
-    if (raw & 0x800000u) raw |= 0xFF000000u;
-    *raw_out = (int32_t)raw;
+    // this conversion was made with the setting latched by the last read
+    uint8_t made_with = h->latched;
+    h->latched = h->gain;
+    if (made_with != h->gain) {
+        // first read after init: unknown, one is enough; a real change: settle
+        h->settle_left = (made_with == LATCH_UNKNOWN) ? 1u : (uint8_t)HX711_SETTLE_CONV;
+    }
+    if (h->settle_left) {
+        h->settle_left--;
+        return -3;
+    }
+
+    for (unsigned c = 0; c < n; c++) {
+        if (raw[c] & 0x800000u) raw[c] |= 0xFF000000u;
+        raw_out[c] = (int32_t)raw[c];
+    }
     return 0;
 }
 
 float hx711_raw_to_kg(const hx711_t *h, int32_t raw){
     return (float)(raw - h->tare_offset_cts) / h->counts_per_kg;
 }
+
+void hx711_set_gain(hx711_t *h, hx711_gain_t gain){
+    if (!h || gain > HX711_GAIN_A64) return;
+    h->gain = (uint8_t)gain;
+}
+
+unsigned hx711_rate_sps(const hx711_t *h){
+    if (!h || h->period_n < HX711_RATE_SAMPLES || h->period_ns == 0) return 0;
+    // 100 ms vs 12.5 ms: split at the geometric middle
+    return (h->period_ns < 35000000u) ? 80u : 10u;
+}
+
+int hx711_parse_gain(const char *s, uint32_t *out){
+    if (!s || !out) return -1;
+    if (strcmp(s, "a128") == 0 || strcmp(s, "128") == 0) { *out = HX711_GAIN_A128; return 0; }
+    if (strcmp(s, "b32") == 0  || strcmp(s, "32") == 0)  { *out = HX711_GAIN_B32;  return 0; }
+    if (strcmp(s, "a64") == 0  || strcmp(s, "64") == 0)  { *out = HX711_GAIN_A64;  return 0; }
+    return -1;
+}
+
+hx711_cal_t hx711_get_cal(const hx711_t *h, unsigned ch){
+    if (ch == 0u || ch >= HX711_MAX_CHANNELS) {
+        return (hx711_cal_t){ .tare_offset_cts = h->tare_offset_cts, .counts_per_kg = h->counts_per_kg };
+    }
+    return h->more[ch - 1u].cal;
+}
+
+void hx711_set_cal(hx711_t *h, unsigned ch, hx711_cal_t cal){
+    if (ch == 0u) {
+        h->tare_offset_cts = cal.tare_offset_cts;
+        h->counts_per_kg = cal.counts_per_kg;
+    } else if (ch < HX711_MAX_CHANNELS) {
+        h->more[ch - 1u].cal = cal;
+    }
+}
+
+float hx711_chan_to_kg(const hx711_t *h, unsigned ch, int32_t raw){
+    hx711_cal_t c = hx711_get_cal(h, ch);
+    return (float)(raw - c.tare_offset_cts) / c.counts_per_kg;
+}
@@ -1,19 +1,92 @@
 #pragma once
 #include <stdint.h>
 
+/*
+    One or more HX711s sharing one SCK line. Channel 0 is dout_line with
+    tare_offset_cts / counts_per_kg; channels 1.. are listed in more[]. All
+    channels are clocked together and their DOUT lines read with one group
+    read per bit, so a read costs the same GPIO calls however many channels
+    there are.
+
+    A single channel waits on DOUT falling-edge events. With several, the
+    read starts once every DOUT is low (polled through the group); a chip
+    that converted earlier just holds its word until then.
+*/
+#define HX711_MAX_CHANNELS  8u
+#define HX711_POLL_US       1000u   // ready poll period with several channels
+
+/*
+    Input and gain, set by 1..3 SCK pulses after the 24 data bits. The
+    setting applies from the next conversion on, and the datasheet gives
+    the output 4 conversions to settle after a change, so those are
+    discarded (hx711_read_raw() returns -3). After init the chip's current
+    setting is unknown: the first conversion is always dropped.
+*/
+typedef enum {
+    HX711_GAIN_A128 = 0,        // 25 pulses (power-on default)
+    HX711_GAIN_B32  = 1,        // 26 pulses
+    HX711_GAIN_A64  = 2,        // 27 pulses
+} hx711_gain_t;
+
+#define HX711_SETTLE_CONV   4u
+
+// Data rate is strapped on the RATE pin (10 or 80 SPS); the driver
+// measures it from the ready timestamps of back-to-back reads.
+#define HX711_RATE_SAMPLES  8u
+
+typedef struct hx711_cal {
+    int32_t tare_offset_cts;
+    float   counts_per_kg;
+} hx711_cal_t;
+
 typedef struct hx711 {
     const char *gpiochip;
     uint8_t sck_line;
     uint8_t dout_line;
     int32_t tare_offset_cts;
     float counts_per_kg;
+
+    uint8_t gain;               // hx711_gain_t, same for every channel (shared SCK)
+    uint8_t channels;           // 0 or 1 = just dout_line
+    struct {
+        uint8_t     dout_line;
+        hx711_cal_t cal;
+    } more[HX711_MAX_CHANNELS - 1u];    // channel i is more[i - 1]
+
     void *chip;
     void *sck;
-    void *dout;
+    void *dout;                 // a line for one channel, a group for several
+    uint8_t  edge_events;       // DOUT requested for falling-edge events
+    uint64_t ready_ns;          // monotonic time DOUT signalled the last conversion ready
+    uint64_t io_calls;          // GPIO calls (ioctls on libgpiod) issued by the driver
+
+    uint8_t  latched;           // setting the next conversion is made with, 0xff = unknown
+    uint8_t  settle_left;       // conversions still to discard
+    uint32_t period_ns;         // measured conversion period, 0 = not yet known
+    uint32_t period_n;          // intervals averaged into period_ns
 } hx711_t;
 
 int  hx711_init(hx711_t *h);
 void hx711_close(hx711_t *h);
 
+static inline unsigned hx711_channels(const hx711_t *h){
+    return (h->channels > 1u) ? h->channels : 1u;
+}
+
+// One conversion from every channel: raw[0 .. hx711_channels() - 1].
+// 0 = ok, -1 not initialised, -2 no conversion within 2 s, -3 clocked out
+// but discarded (input / gain still settling).
 int  hx711_read_raw(hx711_t *h, int32_t *raw);
+
+// Change input / gain; takes effect with the next read. Reader thread only.
+void hx711_set_gain(hx711_t *h, hx711_gain_t gain);
+
+// Measured data rate, rounded to the RATE pin settings: 10, 80, or 0 until
+// HX711_RATE_SAMPLES back-to-back conversions have been seen.
+unsigned hx711_rate_sps(const hx711_t *h);
+int  hx711_parse_gain(const char *s, uint32_t *out);
 float hx711_raw_to_kg(const hx711_t *h, int32_t raw);
+
+hx711_cal_t hx711_get_cal(const hx711_t *h, unsigned ch);
+void  hx711_set_cal(hx711_t *h, unsigned ch, hx711_cal_t cal);
+float hx711_chan_to_kg(const hx711_t *h, unsigned ch, int32_t raw);
@@ -1,41 +1,120 @@
 #include "hx711_thread.h"
 #include "shared.h"
+#include "telemetry.h"
 
 #include <pthread.h>
-#include <time.h>
 #include <stdatomic.h>
+#include <stdlib.h>
+
+_Static_assert(HX711_MAX_CHANNELS <= SCALE_MAX_CHANNELS, "a ring per HX711 channel");
+
+typedef struct {
+    scale_filter_cfg_t filter;
+    hx711_cal_t cal[HX711_MAX_CHANNELS];
+    unsigned n;
+} hx711_reconf_t;
+
+// newest unapplied reconfiguration; ownership moves with the exchange
+static _Atomic(hx711_reconf_t*) pending;
+
+// tare-only updates from zero tracking: offset in the low word, TARE_SET
+// marks it valid. No allocation and no filter restart.
+#define TARE_SET (1ull << 32)
+static _Atomic uint64_t pending_tare[HX711_MAX_CHANNELS];
+
+static _Atomic unsigned rate_sps;
 
 typedef struct {
     const volatile sig_atomic_t *running;
     hx711_t *dev;
+    unsigned n;
+    scale_filter_t filter[HX711_MAX_CHANNELS];
 } hx711_thr_args_t;
 
-static void nsleep(long ns){
-    struct timespec ts = { .tv_sec = 0, .tv_nsec = ns };
-    nanosleep(&ts, 0);
-}
-
 static void* hx711_thread_fn(void *p){
     hx711_thr_args_t *a = (hx711_thr_args_t*)p;
 
+    // hx711_read_raw() blocks until DOUT signals the next conversion, so
+    // the loop is paced by the ADC itself. Every conversion goes through
+    // the filter chain; only accepted samples are published, in filtered counts.
     while (*(a->running)) {
-        int32_t raw;
-        if (hx711_read_raw(a->dev, &raw) == 0) {
-            float kg = hx711_raw_to_kg(a->dev, raw);
-            atomic_store(&scale_raw_value, raw);
-            atomic_store(&g_scale_kg, kg);
+        hx711_reconf_t *rc = atomic_exchange_explicit(&pending, NULL, memory_order_acquire);
+        if (rc) {
+            for (unsigned c = 0; c < a->n; c++) {
+                scale_filter_init(&a->filter[c], &rc->filter);
+                if (c < rc->n) hx711_set_cal(a->dev, c, rc->cal[c]);
+            }
+            free(rc);
+        }
+        for (unsigned c = 0; c < a->n; c++) {
+            uint64_t t = atomic_exchange_explicit(&pending_tare[c], 0, memory_order_relaxed);
+            if (t & TARE_SET) {
+                hx711_cal_t cal = hx711_get_cal(a->dev, c);
+                cal.tare_offset_cts = (int32_t)(uint32_t)t;
+                hx711_set_cal(a->dev, c, cal);
+            }
+        }
+
+        int32_t raw[HX711_MAX_CHANNELS], cts;
+        int err = hx711_read_raw(a->dev, raw);
+        if (err == -2) scale_state_set_status(&g_scale_state, SCALE_TIMEOUT);
+        if (err != 0) continue;
+        uint64_t t_ns = a->dev->ready_ns;
+        atomic_store_explicit(&rate_sps, hx711_rate_sps(a->dev), memory_order_relaxed);
+        for (unsigned c = 0; c < a->n; c++) {
+            if (!scale_filter_process(&a->filter[c], raw[c], &cts)) {
+                telemetry_hx711((uint8_t)c, raw[c], TLM_REJECTED, 0.0f, t_ns);
+                continue;
+            }
+
+            float kg = hx711_chan_to_kg(a->dev, c, cts);
+            telemetry_hx711((uint8_t)c, raw[c], cts, kg, t_ns);
+            scale_ring_push(scale_channel_ring(c), cts, kg, t_ns);
+            if (c == 0) scale_state_publish(&g_scale_state, cts, kg, t_ns);
         }
-        nsleep(50L * 1000L * 1000L); // 50 ms
     }
     return 0;
 }
 
-int hx711_thread_start(const volatile sig_atomic_t *running, hx711_t *dev){
+int hx711_thread_start(const volatile sig_atomic_t *running, hx711_t *dev,
+                       const scale_filter_cfg_t *fcfg){
     static pthread_t th;
     static hx711_thr_args_t args;
 
     args.running = running;
     args.dev = dev;
+    args.n = hx711_channels(dev);
+
+    scale_filter_cfg_t pass;
+    if (!fcfg) {
+        scale_filter_cfg_defaults(&pass);
+        fcfg = &pass;
+    }
+    for (unsigned c = 0; c < args.n; c++) scale_filter_init(&args.filter[c], fcfg);
 
     return pthread_create(&th, 0, hx711_thread_fn, &args);
 }
+
+int hx711_thread_reconfigure(const scale_filter_cfg_t *fcfg, const hx711_cal_t *cal, unsigned n){
+    hx711_reconf_t *rc = malloc(sizeof(*rc));
+    if (!rc) return -1;
+    if (fcfg) rc->filter = *fcfg;
+    else scale_filter_cfg_defaults(&rc->filter);
+    rc->n = (n < HX711_MAX_CHANNELS) ? n : HX711_MAX_CHANNELS;
+    for (unsigned c = 0; c < rc->n; c++) rc->cal[c] = cal[c];
+
+    for (unsigned c = 0; c < HX711_MAX_CHANNELS; c++) {
+        atomic_store_explicit(&pending_tare[c], 0, memory_order_relaxed);
+    }
+    free(atomic_exchange_explicit(&pending, rc, memory_order_acq_rel));
+    return 0;
+}
+
+unsigned hx711_thread_rate_sps(void){
+    return atomic_load_explicit(&rate_sps, memory_order_relaxed);
+}
+
+void hx711_thread_set_tare(unsigned ch, int32_t tare_offset_cts){
+    if (ch >= HX711_MAX_CHANNELS) return;
+    atomic_store_explicit(&pending_tare[ch], TARE_SET | (uint32_t)tare_offset_cts, memory_order_relaxed);
+}
@@ -1,5 +1,22 @@
 #pragma once
 #include <signal.h>
 #include "hx711_driver.h"
+#include "scale_filter.h"
 
-int hx711_thread_start(const volatile sig_atomic_t *running, hx711_t *dev);
+// fcfg may be NULL (no filtering). The config is copied; every channel of
+// dev runs its own instance of the chain. Channel c is published to
+// scale_channel_ring(c); channel 0 also to g_scale_state.
+int hx711_thread_start(const volatile sig_atomic_t *running, hx711_t *dev,
+                       const scale_filter_cfg_t *fcfg);
+
+// Swap in a new filter chain and calibration for channels 0 .. n-1. Picked
+// up by the thread before its next conversion; the filters restart from
+// that sample. Control thread only. Returns 0, or -1 if out of memory.
+int hx711_thread_reconfigure(const scale_filter_cfg_t *fcfg, const hx711_cal_t *cal, unsigned n);
+
+// Data rate measured by the driver (10 or 80), 0 until known. Any thread.
+unsigned hx711_thread_rate_sps(void);
+
+// Move one channel's tare only, keeping the filter state. Applied before
+// the next conversion; a later hx711_thread_reconfigure() supersedes it.
+void hx711_thread_set_tare(unsigned ch, int32_t tare_offset_cts);
@@ -1,28 +1,32 @@
 // File: src/hardware/stepper_driver.c
 #include "stepper_driver.h"
 
-#include <gpiod.h>
+#include "gpio_backend.h"
+#include "notify.h"
+
+#include <stddef.h>
+#include <math.h>
 #include <time.h>
 
 #define DIR_SETUP_US        10u
 #define MAX_SPS             200000u
+#define MIN_SPS             16u         // keeps the step period inside Q16.16
 #define ENABLE_SETTLE_US    200000u
+#define TICKS_PER_S         1000000u    // planner time base: 1 us
+
+// bits of the step/dir/enable output group
+#define OUT_STEP            (1u << 0)
+#define OUT_DIR             (1u << 1)
+#define OUT_EN              (1u << 2)
 
-static struct {
-    stepper_motor     *m;
-    struct gpiod_chip *chip;
-    struct gpiod_line *step;
-    struct gpiod_line *dir;
-    struct gpiod_line *en;
-    struct gpiod_line *home;
-} g = {0};
+static void out_write(stepper_motor *m, uint32_t bits){
+    m->out_bits = bits;
+    m->io_calls++;
+    (void)gpio_set_group(m->out, bits);
+}
 
-static uint32_t now_us_local(void){
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t us = (uint64_t)(int64_t)ts.tv_sec * 1000000u
-                + (uint64_t)(int64_t)ts.tv_nsec / 1000u;
-    return (uint32_t)us;
+static uint32_t en_bits(uint8_t active_level, int on){
+    return ((on ? 1 : 0) == (active_level ? 1 : 0)) ? OUT_EN : 0u;
 }
 
 static uint32_t clamp_u32(uint32_t x, uint32_t lo, uint32_t hi){
@@ -31,9 +35,78 @@ static uint32_t clamp_u32(uint32_t x, uint32_t lo, uint32_t hi){
     return x;
 }
 
+/*
+    Motion planner.
+
+    With p the step period in timer ticks, F the tick rate and a the
+    acceleration, one step of constant acceleration changes the period by
+        p' = p / sqrt(1 +/- 2q),   q = a * p^2 / F^2
+    which we expand to p' = p * (1 -/+ q + 1.5 q^2). That is multiplies and
+    shifts only, so the per-step update needs no division. q <= 0.5 holds
+    because p never exceeds the standstill period F / sqrt(2a).
+
+    ramp_n counts the steps taken up the ramp, which by symmetry is also the
+    number of steps needed to stop. Deceleration starts as soon as the
+    remaining distance drops to ramp_n, so moves too short to reach cruise
+    speed turn into triangles on their own.
+*/
+static void ramp_init(stepper_motor *m, uint32_t speed_sps, uint32_t acc_sps2){
+    uint32_t sps = clamp_u32(speed_sps, MIN_SPS, MAX_SPS);
+    m->ramp_min_q16 = (uint32_t)(((uint64_t)TICKS_PER_S << 16) / sps);
+
+    if (acc_sps2 == 0) {
+        m->ramp_start_q16 = m->ramp_min_q16;
+        m->ramp_m_q48 = 0;
+    } else {
+        double p0 = (double)TICKS_PER_S / sqrt(2.0 * (double)acc_sps2) * 65536.0;
+        uint32_t max_q16 = (uint32_t)(((uint64_t)TICKS_PER_S << 16) / MIN_SPS);
+        m->ramp_start_q16 = (p0 > (double)max_q16) ? max_q16 : (uint32_t)p0;
+        if (m->ramp_start_q16 < m->ramp_min_q16) m->ramp_start_q16 = m->ramp_min_q16;
+        // acc / F^2 in Q48: 2^48 / 1e12 = 281.474976...
+        m->ramp_m_q48 = ((uint64_t)acc_sps2 * 281474977ull) / 1000000ull;
+    }
+
+    m->ramp_period_q16 = m->ramp_start_q16;
+    m->ramp_n          = 0;
+    m->ramp_frac_q16   = 0;
+}
+
+// Advance the period by one step. remaining = steps left after this one.
+static void ramp_step(stepper_motor *m, uint32_t remaining){
+    if (m->ramp_m_q48 == 0) return;
+
+    uint32_t p = m->ramp_period_q16;
+    uint64_t p2_us = ((uint64_t)p * p) >> 32;                   // integer us^2
+    uint64_t q  = (p2_us * m->ramp_m_q48) >> 16;                // Q32
+    uint64_t q2 = (q * q) >> 32;
+    uint64_t d2 = q2 + (q2 >> 1);                                // 1.5 q^2
+
+    if (m->ramp_n > 0 && remaining <= m->ramp_n) {
+        // decelerate
+        uint64_t dp = ((uint64_t)p * (q + d2)) >> 32;
+        uint64_t np = (uint64_t)p + dp;
+        m->ramp_period_q16 = (np > m->ramp_start_q16) ? m->ramp_start_q16 : (uint32_t)np;
+        m->ramp_n--;
+    } else if (p > m->ramp_min_q16) {
+        // accelerate
+        uint64_t dp = ((uint64_t)p * (q - d2)) >> 32;
+        uint32_t np = (uint32_t)((uint64_t)p - dp);
+        m->ramp_period_q16 = (np < m->ramp_min_q16) ? m->ramp_min_q16 : np;
+        m->ramp_n++;
+    }
+    // else: cruise
+}
+
+// Integer us for the next step, carrying the Q16 fraction so the average rate stays exact.
+static uint32_t ramp_period_us(stepper_motor *m){
+    uint32_t acc = m->ramp_frac_q16 + (m->ramp_period_q16 & 0xFFFFu);
+    m->ramp_frac_q16 = acc & 0xFFFFu;
+    return (m->ramp_period_q16 >> 16) + (acc >> 16);
+}
+
 int stepper_home_read(const stepper_motor *m, int *raw_out, int *active_out){
-    if (!m || !g.home) return -1;
-    int v = gpiod_line_get_value(g.home);
+    if (!m || !m->home) return -1;
+    int v = gpio_get_value(m->home);
     if (v < 0) return -2;
 
     if (raw_out) *raw_out = v;
@@ -41,228 +114,466 @@ int stepper_home_read(const stepper_motor *m, int *raw_out, int *active_out){
     return 0;
 }
 
-static int home_is_active(const stepper_motor *m){
+static int home_is_active(stepper_motor *m){
     int active = 0;
+    m->io_calls++;
     (void)stepper_home_read(m, NULL, &active);
+    m->home_active = (uint8_t)active;
     return active;
 }
 
-int stepper_init(stepper_motor *m){
-    if (!m || !m->gpiochip) return -1;
+// RT side (and init): publish the fields stepper_get_status() hands out.
+static void publish(stepper_motor *m){
+    uint32_t word = (uint32_t)m->state | ((uint32_t)(m->homed ? 1u : 0u) << 8)
+                  | ((uint32_t)(m->home_active ? 1u : 0u) << 9);
+    uint32_t gen = atomic_load_explicit(&m->snap_gen, memory_order_relaxed);
+    atomic_store_explicit(&m->snap_gen, gen + 1u, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&m->snap_word, word, memory_order_relaxed);
+    atomic_store_explicit(&m->snap_pos, m->cur_pos_stp, memory_order_relaxed);
+    atomic_store_explicit(&m->snap_period, m->cur_period_us, memory_order_relaxed);
+    atomic_store_explicit(&m->snap_gen, gen + 2u, memory_order_release);
+}
 
-    g.chip = gpiod_chip_open(m->gpiochip);
-    if (!g.chip) return -2;
+void stepper_get_status(const stepper_motor *m, stepper_status_t *out){
+    if (!m || !out) return;
+    uint32_t g0, g1, word, period;
+    int32_t pos;
+    do {
+        g0 = atomic_load_explicit(&m->snap_gen, memory_order_acquire);
+        word  = atomic_load_explicit(&m->snap_word, memory_order_relaxed);
+        pos   = atomic_load_explicit(&m->snap_pos, memory_order_relaxed);
+        period = atomic_load_explicit(&m->snap_period, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        g1 = atomic_load_explicit(&m->snap_gen, memory_order_relaxed);
+    } while ((g0 & 1u) || g0 != g1);
+
+    out->state       = (stepper_state_t)(word & 0xFFu);
+    out->homed       = (uint8_t)((word >> 8) & 1u);
+    out->home_active = (uint8_t)((word >> 9) & 1u);
+    out->pos_stp     = pos;
+    out->speed_sps   = stepper_period_to_sps(period);
+}
 
-    g.step = gpiod_chip_get_line(g.chip, m->pul_pin);
-    g.dir  = gpiod_chip_get_line(g.chip, m->dir_pin);
-    g.en   = gpiod_chip_get_line(g.chip, m->enable_pin);
-    if (!g.step || !g.dir || !g.en) return -3;
+int stepper_init(stepper_motor *m){
+    if (!m || !m->gpiochip) return -1;
 
-    if (gpiod_line_request_output(g.step, "stp_step", 0) < 0) return -4;
-    if (gpiod_line_request_output(g.dir,  "stp_dir",  0) < 0) return -5;
+    m->chip = gpio_chip_open(m->gpiochip);
+    if (!m->chip) return -2;
 
-    int en_idle = (m->en_active_level ? 0 : 1);
-    if (gpiod_line_request_output(g.en, "stp_en", en_idle) < 0) return -6;
+    const unsigned offsets[3] = { m->pul_pin, m->dir_pin, m->enable_pin };
+    m->out_bits = en_bits(m->en_active_level, 0);
+    m->out = gpio_request_output_group(m->chip, offsets, 3, "stp_out", m->out_bits);
+    if (!m->out) {
+        gpio_chip_close(m->chip);
+        m->chip = NULL;
+        return -4;
+    }
 
-    g.home = gpiod_chip_get_line(g.chip, m->home_pin);
-    if (!g.home) return -7;
-    if (gpiod_line_request_input(g.home, "stp_home") < 0) return -8;
+    m->home = gpio_request_input(m->chip, m->home_pin, "stp_home");
+    if (!m->home) {
+        gpio_release_group(m->out);
+        gpio_chip_close(m->chip);
+        m->out = m->chip = NULL;
+        return -8;
+    }
 
     m->cur_pos_stp       = 0;
-    m->cur_speed_sps     = 0;
-    m->cur_speed_fp      = 0;
+    m->cur_period_us     = 0;
+    m->peak_period_us    = 0;
 
     m->target_pos_stp    = 0;
     m->target_speed_sps  = 0;
     m->target_acc_sps2   = 0;
 
-    m->last_speed_us     = 0;
     m->enabled_at_us     = 0;
     m->need_dir_setup    = 0;
 
     m->step_level        = 0;
     m->next_edge_us      = 0;
-    gpiod_line_set_value(g.step, 0);
+    m->io_calls          = 0;
+
+    atomic_store(&m->q_head, 0u);
+    atomic_store(&m->q_tail, 0u);
+    atomic_store(&m->done_seq, 0u);
+    atomic_store(&m->evt_seq, 0u);
+    atomic_store(&m->snap_gen, 0u);
+    m->q_next_seq        = 0;
+    m->cur_seq           = 0;
+    m->dwelling          = 0;
 
     m->homed = 0;
     m->state = STP_READY;
-    g.m = m;
+    (void)home_is_active(m);
+    publish(m);
     return 0;
 }
 
 int stepper_enable(stepper_motor *m){
-    if (!m || g.m != m || !g.en) return -1;
-
-    gpiod_line_set_value(g.en, m->en_active_level ? 1 : 0);
-    m->enabled_at_us = now_us_local();
-
-    m->state = STP_ENABLED;
-    return 0;
+    if (!m || !m->out) return -1;
+    return stepper_queue_enable(m, 1) ? 0 : -2;
 }
 
 int stepper_disable(stepper_motor *m){
-    if (!m || g.m != m || !g.en) return -1;
-    gpiod_line_set_value(g.en, m->en_active_level ? 0 : 1);
-    m->state = STP_READY;
-    return 0;
+    if (!m || !m->out) return -1;
+    return stepper_queue_enable(m, 0) ? 0 : -2;
 }
 
 void stepper_set_pos(stepper_motor *m, int32_t pos_stp){
-    if (!m) return;
-    m->cur_pos_stp = pos_stp;
+    (void)stepper_queue_set_pos(m, pos_stp);
 }
 
 float stepper_get_pos_deg(const stepper_motor *m){
     if (!m || m->stp_per_rev == 0) return 0.0f;
-    return (float)m->cur_pos_stp * (360.0f / (float)m->stp_per_rev);
+    stepper_status_t st;
+    stepper_get_status(m, &st);
+    return (float)st.pos_stp * (360.0f / (float)m->stp_per_rev);
 }
 
-int stepper_start_move_abs(stepper_motor *m, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2){
-    if (!m || g.m != m) return -1;
-    if (speed_sps == 0) return -2;
+// RT side: apply an ENABLE command.
+static void apply_enable(stepper_motor *m, int on, uint32_t now_us){
+    out_write(m, (m->out_bits & ~OUT_EN) | en_bits(m->en_active_level, on));
+    if (on) {
+        // 0 means "settled", so never store it as a start time
+        m->enabled_at_us = now_us ? now_us : 1u;
+        m->state = STP_ENABLED;
+    } else {
+        m->enabled_at_us = 0;
+        m->state = STP_READY;
+    }
+    (void)home_is_active(m);
+}
+
+void stepper_shutdown(stepper_motor *m){
+    if (!m || !m->out) return;
+    apply_enable(m, 0, 0);
+    publish(m);
+}
 
+static void begin_move(stepper_motor *m, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2){
     m->target_pos_stp    = abs_stp;
     m->target_speed_sps  = speed_sps;
     m->target_acc_sps2   = acc_sps2;
 
-    m->cur_speed_fp      = 0;
-    m->cur_speed_sps     = 0;
-    m->last_speed_us     = 0;
+    m->cur_period_us     = 0;
+    m->peak_period_us    = 0;
+    ramp_init(m, speed_sps, acc_sps2);
 
     m->step_level        = 0;
     m->next_edge_us      = 0;
-    gpiod_line_set_value(g.step, 0);
 
     int32_t delta = m->target_pos_stp - m->cur_pos_stp;
     int dir = (delta >= 0) ? 1 : 0;
     if (m->dir_invert) dir ^= 1;
-    gpiod_line_set_value(g.dir, dir);
+    // step low and the new DIR level in one write
+    out_write(m, (m->out_bits & ~(OUT_STEP | OUT_DIR)) | (dir ? OUT_DIR : 0u));
     m->need_dir_setup = 1;
 
     m->state = STP_MOVING;
-    return 0;
-}
-
-int stepper_start_move_rel(stepper_motor *m, int32_t delta_stp, uint32_t speed_sps, uint32_t acc_sps2){
-    if (!m) return -1;
-    return stepper_start_move_abs(m, m->cur_pos_stp + delta_stp, speed_sps, acc_sps2);
 }
 
-int stepper_start_homing(stepper_motor *m, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir){
-    if (!m || g.m != m) return -1;
-    if (speed_sps == 0) return -2;
-    if (dir != 1 && dir != -1) return -3;
-
+static void begin_homing(stepper_motor *m, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir){
     m->target_speed_sps = speed_sps;
     m->target_acc_sps2  = acc_sps2;
-    m->cur_speed_fp     = 0;
-    m->cur_speed_sps    = 0;
-    m->last_speed_us    = 0;
+    m->cur_period_us    = 0;
+    m->peak_period_us   = 0;
+    ramp_init(m, speed_sps, acc_sps2);
 
     m->step_level   = 0;
     m->next_edge_us = 0;
-    gpiod_line_set_value(g.step, 0);
 
     int out_dir = (dir > 0) ? 1 : 0;
     if (m->dir_invert) out_dir ^= 1;
-    gpiod_line_set_value(g.dir, out_dir);
+    out_write(m, (m->out_bits & ~(OUT_STEP | OUT_DIR)) | (out_dir ? OUT_DIR : 0u));
     m->need_dir_setup = 1;
 
     m->homed = 0;
     m->state = STP_HOMING;
-    return 0;
 }
 
-void stepper_update(stepper_motor *m, uint32_t now_us){
-    if (!m || g.m != m) return;
-    if (m->state != STP_MOVING && m->state != STP_HOMING) return;
+int stepper_start_move_abs(stepper_motor *m, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2){
+    if (!m || !m->out) return -1;
+    if (speed_sps == 0) return -2;
+    return stepper_queue_move_abs(m, abs_stp, speed_sps, acc_sps2) ? 0 : -4;
+}
+
+int stepper_start_move_rel(stepper_motor *m, int32_t delta_stp, uint32_t speed_sps, uint32_t acc_sps2){
+    if (!m || !m->out) return -1;
+    if (speed_sps == 0) return -2;
+    return stepper_queue_move_rel(m, delta_stp, speed_sps, acc_sps2) ? 0 : -4;
+}
 
-    if (m->enabled_at_us != 0) {
-        if ((uint32_t)(now_us - m->enabled_at_us) < ENABLE_SETTLE_US) return;
+int stepper_start_homing(stepper_motor *m, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir){
+    if (!m || !m->out) return -1;
+    if (speed_sps == 0) return -2;
+    if (dir != 1 && dir != -1) return -3;
+    return stepper_queue_homing(m, speed_sps, acc_sps2, dir) ? 0 : -4;
+}
+
+// ---- command queue ----
+
+static int cmd_valid(const stepper_cmd_t *cmd){
+    if ((cmd->kind == STP_CMD_MOVE_ABS || cmd->kind == STP_CMD_MOVE_REL || cmd->kind == STP_CMD_HOME) &&
+        cmd->speed_sps == 0) return 0;
+    if (cmd->kind == STP_CMD_HOME && cmd->dir != 1 && cmd->dir != -1) return 0;
+    return 1;
+}
+
+uint32_t stepper_queue_push_n(stepper_motor *m, const stepper_cmd_t *cmds, unsigned n, uint32_t *seqs){
+    if (!m || !cmds || n == 0 || n > STEPPER_QUEUE_LEN) return 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (!cmd_valid(&cmds[i])) return 0;
     }
 
-    int32_t delta = m->target_pos_stp - m->cur_pos_stp;
+    uint32_t head = atomic_load_explicit(&m->q_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&m->q_tail, memory_order_acquire);
+    if (STEPPER_QUEUE_LEN - (head - tail) < n) return 0;
 
-    if (m->state == STP_MOVING) {
-        if (delta == 0) { m->state = STP_ENABLED; return; }
-    } else { // STP_HOMING
-        if (home_is_active(m)) {
-            gpiod_line_set_value(g.step, 0);
-            m->step_level = 0;
-            m->next_edge_us = 0;
-            m->cur_speed_fp = 0;
-            m->cur_speed_sps = 0;
-            m->state = STP_ENABLED;
-            m->homed = 1;
-            return;
+    uint32_t seq = 0;
+    for (unsigned i = 0; i < n; i++) {
+        seq = ++m->q_next_seq;
+        if (seq == 0) seq = ++m->q_next_seq;
+
+        stepper_cmd_t *slot = &m->queue[(head + i) & (STEPPER_QUEUE_LEN - 1u)];
+        *slot = cmds[i];
+        slot->seq = seq;
+        if (seqs) seqs[i] = seq;
+    }
+    // one publish: the RT thread sees all n commands or none
+    atomic_store_explicit(&m->q_head, head + n, memory_order_release);
+
+    notify_post(m->bell ? m->bell : &m->cmd_seq);
+    return seq;
+}
+
+uint32_t stepper_queue_push(stepper_motor *m, const stepper_cmd_t *cmd){
+    return stepper_queue_push_n(m, cmd, 1u, NULL);
+}
+
+uint32_t stepper_queue_move_abs(stepper_motor *m, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2){
+    stepper_cmd_t c = { .kind = STP_CMD_MOVE_ABS, .pos_stp = abs_stp,
+                        .speed_sps = speed_sps, .acc_sps2 = acc_sps2 };
+    return stepper_queue_push(m, &c);
+}
+
+uint32_t stepper_queue_move_rel(stepper_motor *m, int32_t delta_stp, uint32_t speed_sps, uint32_t acc_sps2){
+    stepper_cmd_t c = { .kind = STP_CMD_MOVE_REL, .pos_stp = delta_stp,
+                        .speed_sps = speed_sps, .acc_sps2 = acc_sps2 };
+    return stepper_queue_push(m, &c);
+}
+
+uint32_t stepper_queue_enable(stepper_motor *m, int on){
+    stepper_cmd_t c = { .kind = STP_CMD_ENABLE, .dir = (int8_t)(on ? 1 : 0) };
+    return stepper_queue_push(m, &c);
+}
+
+uint32_t stepper_queue_dwell(stepper_motor *m, uint32_t dwell_us){
+    stepper_cmd_t c = { .kind = STP_CMD_DWELL, .dwell_us = dwell_us };
+    return stepper_queue_push(m, &c);
+}
+
+uint32_t stepper_queue_homing(stepper_motor *m, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir){
+    stepper_cmd_t c = { .kind = STP_CMD_HOME, .dir = dir, .speed_sps = speed_sps, .acc_sps2 = acc_sps2 };
+    return stepper_queue_push(m, &c);
+}
+
+uint32_t stepper_queue_set_pos(stepper_motor *m, int32_t pos_stp){
+    stepper_cmd_t c = { .kind = STP_CMD_SET_POS, .pos_stp = pos_stp };
+    return stepper_queue_push(m, &c);
+}
+
+int stepper_seq_done(const stepper_motor *m, uint32_t seq){
+    if (!m) return 0;
+    uint32_t done = atomic_load_explicit(&m->done_seq, memory_order_acquire);
+    return (int32_t)(done - seq) >= 0;
+}
+
+int stepper_wait_done(stepper_motor *m, uint32_t seq, uint32_t timeout_ms){
+    if (!m) return -2;
+
+    struct timespec deadline;
+    notify_deadline(&deadline, timeout_ms);
+
+    for (;;) {
+        uint32_t ev = atomic_load_explicit(&m->evt_seq, memory_order_acquire);
+        if (stepper_seq_done(m, seq)) return 0;
+        stepper_status_t st;
+        stepper_get_status(m, &st);
+        if (st.state == STP_FAULT) return -2;
+        if (notify_wait(&m->evt_seq, ev, timeout_ms ? &deadline : NULL) < 0) {
+            return stepper_seq_done(m, seq) ? 0 : -1;
         }
     }
+}
 
-    if (m->need_dir_setup) {
-        m->need_dir_setup = 0;
-        m->last_speed_us  = now_us;
-        m->next_edge_us   = now_us + DIR_SETUP_US;
-        m->step_level     = 0;
-        gpiod_line_set_value(g.step, 0);
-        return;
+// RT side: publish a transition to stepper_wait_done() callers.
+static void mark_done(stepper_motor *m, uint32_t seq){
+    if (seq == 0) return;
+    atomic_store_explicit(&m->done_seq, seq, memory_order_release);
+    notify_post(&m->evt_seq);
+}
+
+// RT side: pop and start the next command. Returns 1 if a segment is now running.
+static int queue_start_next(stepper_motor *m, uint32_t now_us){
+    for (;;) {
+        uint32_t tail = atomic_load_explicit(&m->q_tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&m->q_head, memory_order_acquire)) return 0;
+
+        stepper_cmd_t c = m->queue[tail & (STEPPER_QUEUE_LEN - 1u)];
+        atomic_store_explicit(&m->q_tail, tail + 1u, memory_order_release);
+
+        switch (c.kind) {
+        case STP_CMD_MOVE_ABS:
+            begin_move(m, c.pos_stp, c.speed_sps, c.acc_sps2);
+            m->cur_seq = c.seq;
+            return 1;
+        case STP_CMD_MOVE_REL:
+            begin_move(m, m->cur_pos_stp + c.pos_stp, c.speed_sps, c.acc_sps2);
+            m->cur_seq = c.seq;
+            return 1;
+        case STP_CMD_HOME:
+            begin_homing(m, c.speed_sps, c.acc_sps2, c.dir);
+            m->cur_seq = c.seq;
+            return 1;
+        case STP_CMD_DWELL:
+            m->dwelling = 1;
+            m->dwell_until_us = now_us + c.dwell_us;
+            m->state = STP_MOVING;
+            m->cur_seq = c.seq;
+            return 1;
+        case STP_CMD_SET_POS:
+            m->cur_pos_stp = c.pos_stp;
+            publish(m);
+            mark_done(m, c.seq);
+            break;
+        case STP_CMD_ENABLE:
+            apply_enable(m, c.dir, now_us);
+            publish(m);
+            mark_done(m, c.seq);
+            break;
+        default:
+            mark_done(m, c.seq);
+            break;
+        }
     }
+}
 
-    if (m->last_speed_us == 0) m->last_speed_us = now_us;
-    uint32_t dt_us = (uint32_t)(now_us - m->last_speed_us);
-    m->last_speed_us = now_us;
+// Current segment finished: report it and, if more is queued, chain
+// straight into it so back-to-back strokes have no idle gap.
+static int segment_done(stepper_motor *m, uint32_t now_us, uint32_t *next_us){
+    m->cur_period_us = 0;
+    m->state = STP_ENABLED;
+    publish(m);
+    mark_done(m, m->cur_seq);
+    m->cur_seq = 0;
 
-    uint32_t acc = m->target_acc_sps2;
-    if (acc == 0) {
-        m->cur_speed_fp  = (uint64_t)m->target_speed_sps * 1000000ull;
-    } else {
-        m->cur_speed_fp += (uint64_t)acc * (uint64_t)dt_us;
-        uint64_t max_fp = (uint64_t)m->target_speed_sps * 1000000ull;
-        if (m->cur_speed_fp > max_fp) m->cur_speed_fp = max_fp;
+    if (!queue_start_next(m, now_us)) return 0;
+    *next_us = now_us;
+    return 1;
+}
+
+static int update(stepper_motor *m, uint32_t now_us, uint32_t *next_us){
+    if ((m->state == STP_ENABLED || m->state == STP_READY) && !queue_start_next(m, now_us)) return 0;
+    if (m->state != STP_MOVING && m->state != STP_HOMING) return 0;
+
+    if (m->enabled_at_us != 0) {
+        if ((uint32_t)(now_us - m->enabled_at_us) < ENABLE_SETTLE_US) {
+            *next_us = m->enabled_at_us + ENABLE_SETTLE_US;
+            return 1;
+        }
+        m->enabled_at_us = 0; // settled; also keeps the check from re-arming on wrap
     }
 
-    m->cur_speed_sps = (uint32_t)(m->cur_speed_fp / 1000000ull);
-    uint32_t sps = m->cur_speed_sps;
-    if (sps < 1u) sps = 1u;
-    sps = clamp_u32(sps, 1u, MAX_SPS);
+    if (m->dwelling) {
+        if ((int32_t)(now_us - m->dwell_until_us) < 0) {
+            *next_us = m->dwell_until_us;
+            return 1;
+        }
+        m->dwelling = 0;
+        return segment_done(m, now_us, next_us);
+    }
 
-    uint32_t period_us = 1000000u / sps;
+    int32_t delta = m->target_pos_stp - m->cur_pos_stp;
 
-    uint32_t pw = m->pulse_width_us;
-    if (pw < 3u) pw = 3u;
-    if (pw >= period_us) pw = period_us / 2u;
-    if (pw == 0u) pw = 1u;
+    if (m->state == STP_MOVING) {
+        if (delta == 0) return segment_done(m, now_us, next_us);
+    }
 
-    if (m->next_edge_us == 0) {
-        m->next_edge_us = now_us + period_us;
-        return;
+    if (m->need_dir_setup) {
+        // step is already low and DIR set by the start call
+        m->need_dir_setup = 0;
+        m->next_edge_us   = now_us + DIR_SETUP_US;
+        m->step_level     = 0;
+        m->step_period_us = ramp_period_us(m);
+        *next_us = m->next_edge_us;
+        return 1;
     }
 
-    if ((int32_t)(now_us - m->next_edge_us) < 0) return;
+    if ((int32_t)(now_us - m->next_edge_us) < 0) {
+        *next_us = m->next_edge_us;
+        return 1;
+    }
 
     if (m->step_level == 0) {
-        gpiod_line_set_value(g.step, 1);
+        // homing: sample the switch once per step, right before the rising edge
+        if (m->state == STP_HOMING && home_is_active(m)) {
+            m->next_edge_us = 0;
+            m->homed = 1;
+            return segment_done(m, now_us, next_us);
+        }
+
+        uint32_t pw = m->pulse_width_us;
+        if (pw < 3u) pw = 3u;
+        if (pw >= m->step_period_us) pw = m->step_period_us >> 1;
+        if (pw == 0u) pw = 1u;
+
+        out_write(m, m->out_bits | OUT_STEP);
         m->step_level = 1;
+        // period is measured from the scheduled rise so tick jitter does not pile up
+        m->step_rise_us = m->next_edge_us;
         m->next_edge_us = now_us + pw;
     } else {
-        gpiod_line_set_value(g.step, 0);
+        out_write(m, m->out_bits & ~OUT_STEP);
         m->step_level = 0;
 
+        uint32_t remaining;
         if (m->state == STP_MOVING) {
             delta = m->target_pos_stp - m->cur_pos_stp;
             if (delta != 0) {
                 int step_dir = (delta > 0) ? +1 : -1;
                 m->cur_pos_stp += step_dir;
+                delta -= step_dir;
             }
+            // at remaining == 0 we still wait out the last period, so the
+            // rotor has arrived before the segment is reported done
+            remaining = (uint32_t)((delta < 0) ? -delta : delta);
         } else {
-            // homing: position is just "software tracking"
-            int dir_out = gpiod_line_get_value(g.dir);
-            int phys_dir = dir_out ? +1 : -1;
+            // homing: position is just "software tracking", from the cached DIR level
+            int phys_dir = (m->out_bits & OUT_DIR) ? +1 : -1;
             if (m->dir_invert) phys_dir = -phys_dir;
             m->cur_pos_stp += phys_dir;
+            remaining = UINT32_MAX;
         }
 
-        uint32_t low_us = (period_us > pw) ? (period_us - pw) : 1u;
-        m->next_edge_us = now_us + low_us;
-        m->next_edge_us = now_us + low_us;
+        ramp_step(m, remaining);
+        m->step_period_us = ramp_period_us(m);
+        m->cur_period_us  = m->step_period_us;   // speed is derived by readers: no divide here
+        if (m->peak_period_us == 0 || m->step_period_us < m->peak_period_us) m->peak_period_us = m->step_period_us;
+
+        uint32_t next_rise = m->step_rise_us + m->step_period_us;
+        m->next_edge_us = ((int32_t)(now_us - next_rise) > 0) ? now_us : next_rise;
     }
+
+    *next_us = m->next_edge_us;
+    return 1;
+}
+
+int stepper_update(stepper_motor *m, uint32_t now_us, uint32_t *next_us){
+    if (!m || !m->out || !next_us) return 0;
+    uint64_t io0 = m->io_calls;
+    stepper_state_t st0 = m->state;
+    int busy = update(m, now_us, next_us);
+    // republish only when something moved: a pure wait costs nothing
+    if (m->io_calls != io0 || m->state != st0) publish(m);
+    return busy;
 }
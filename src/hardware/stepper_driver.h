@@ -1,6 +1,7 @@
 // File: src/hardware/stepper_driver.h
 #pragma once
 #include <stdint.h>
+#include <stdatomic.h>
 
 typedef enum {
     STP_UNINIT=0,
@@ -11,6 +12,49 @@ typedef enum {
     STP_FAULT
 } stepper_state_t;
 
+/*
+    Command mailbox. The control thread pushes commands, the RT thread pops
+    and runs them inside stepper_update(), back to back, so a whole deposit
+    stroke needs no control-thread round trip between segments.
+
+    Each stepper_motor carries its own lines and state, so one process can
+    drive several axes (see stepper_thread_start_axes()).
+
+    After stepper_init() the RT thread owns the motor: every command
+    (including enable/disable and set_pos) goes through the mailbox, only
+    the RT thread touches the stepper GPIO and the fields below, and it
+    publishes what the control side may read as a stepper_status_t snapshot.
+*/
+typedef enum {
+    STP_CMD_MOVE_ABS = 1,
+    STP_CMD_DWELL,
+    STP_CMD_HOME,
+    STP_CMD_SET_POS,
+    STP_CMD_MOVE_REL,
+    STP_CMD_ENABLE,
+} stepper_cmd_kind_t;
+
+typedef struct stepper_cmd {
+    uint8_t  kind;              // stepper_cmd_kind_t
+    int8_t   dir;               // HOME: +1 / -1; ENABLE: 1 = on, 0 = off
+    int32_t  pos_stp;           // MOVE_ABS target, MOVE_REL delta, SET_POS value
+    uint32_t speed_sps;
+    uint32_t acc_sps2;
+    uint32_t dwell_us;
+    uint32_t seq;               // assigned by stepper_queue_push()
+} stepper_cmd_t;
+
+#define STEPPER_QUEUE_LEN   16u  // power of two
+
+// What the control side may read while the RT thread runs.
+typedef struct stepper_status {
+    stepper_state_t state;
+    uint8_t  homed;
+    uint8_t  home_active;       // switch level at the last sample (enable, homing)
+    int32_t  pos_stp;
+    uint32_t speed_sps;
+} stepper_status_t;
+
 typedef struct stepper_motor {
     const char *gpiochip;
 
@@ -33,39 +77,138 @@ typedef struct stepper_motor {
     uint32_t target_speed_sps;
     uint32_t target_acc_sps2;
 
-    uint32_t cur_speed_sps;     // integer speed used for period calc
-    uint64_t cur_speed_fp;      // steps/s * 1e6
+    uint32_t cur_period_us;     // period of the last step, 0 = standing; see stepper_period_to_sps()
+    uint32_t peak_period_us;    // shortest period of the current / last segment, 0 = no step yet
     int32_t  cur_pos_stp;
 
     stepper_state_t state;
 
     // timing
-    uint32_t last_speed_us;
     uint32_t enabled_at_us;
     uint8_t  need_dir_setup;
 
+    // motion planner: step period in us, Q16.16 fixed point
+    uint32_t ramp_period_q16;   // current step period
+    uint32_t ramp_start_q16;    // period of the first step from standstill
+    uint32_t ramp_min_q16;      // cruise period (target speed)
+    uint64_t ramp_m_q48;        // acc / 1e12 (Q48), the ramp constant
+    uint32_t ramp_n;            // steps taken up the ramp = steps needed to stop
+    uint32_t ramp_frac_q16;     // sub-us remainder carried between steps
+
     // pulse edge scheduler
     uint8_t  step_level;
+    uint32_t step_period_us;
+    uint32_t step_rise_us;
     uint32_t next_edge_us;
 
+    uint64_t io_calls;          // GPIO calls (ioctls on libgpiod) issued by the driver
+
+    // GPIO handles, set up by stepper_init()
+    void    *chip;
+    void    *out;               // step, dir, enable: one request, one write per edge
+    void    *home;
+    uint32_t out_bits;          // cached output state, never read back
+
+    // bumped (and the RT thread woken) whenever a new command is issued;
+    // when the motor shares an RT thread, bell points at that thread's word
+    _Atomic uint32_t cmd_seq;
+    _Atomic uint32_t *bell;
+
+    // command queue: single producer (control thread), single consumer (RT thread)
+    stepper_cmd_t    queue[STEPPER_QUEUE_LEN];
+    _Atomic uint32_t q_head;
+    _Atomic uint32_t q_tail;
+    uint32_t         q_next_seq;    // producer side
+    uint32_t         cur_seq;       // RT side: seq of the running command, 0 = none
+    uint32_t         dwell_until_us;
+    uint8_t          dwelling;
+    _Atomic uint32_t done_seq;      // seq of the last finished command
+
+    // bumped (and waiters woken) by the RT thread on every transition:
+    // segment done, homed, fault. See stepper_wait_done().
+    _Atomic uint32_t evt_seq;
+
+    // status snapshot, written by the RT thread only (seqlock: odd = writing)
+    uint8_t          home_active;
+    _Atomic uint32_t snap_gen;
+    _Atomic uint32_t snap_word;     // state | homed << 8 | home_active << 9
+    _Atomic int32_t  snap_pos;
+    _Atomic uint32_t snap_period;
+
 } stepper_motor;
 
+// Step period (us) -> steps/s, 0 for a standing motor. Kept off the RT path:
+// the RT thread only records the period, readers divide.
+static inline uint32_t stepper_period_to_sps(uint32_t period_us){
+    return period_us ? 1000000u / period_us : 0u;
+}
+
+// Requests the lines; call before the RT thread starts.
 int   stepper_init(stepper_motor *motor);
+
+// Convenience wrappers that post to the mailbox. 0 = queued, <0 = rejected / full.
 int   stepper_enable(stepper_motor *motor);
 int   stepper_disable(stepper_motor *motor);
-
 void  stepper_set_pos(stepper_motor *motor, int32_t pos_stp);
-float stepper_get_pos_deg(const stepper_motor *motor);
 
 int   stepper_start_homing(stepper_motor *motor, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir);
 int   stepper_start_move_abs(stepper_motor *motor, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2);
 int   stepper_start_move_rel(stepper_motor *motor, int32_t delta_stp, uint32_t speed_sps, uint32_t acc_sps2);
 
-// call as often as possible, pass monotonic time in microseconds
-void  stepper_update(stepper_motor *motor, uint32_t now_us);
+// Snapshot of the RT-owned state; never torn, never blocks the RT thread.
+void  stepper_get_status(const stepper_motor *motor, stepper_status_t *out);
+float stepper_get_pos_deg(const stepper_motor *motor);
+
+/*
+    Mailbox. Push returns the command's sequence number (never 0), or 0 if
+    the queue is full. Commands run strictly in order. Single producer: only
+    the control thread may post.
+*/
+uint32_t stepper_queue_push(stepper_motor *motor, const stepper_cmd_t *cmd);
+
+// All of cmds[0 .. n-1] or none: 0 if any is invalid or fewer than n slots
+// are free. Otherwise returns the last seq and stores each one in seqs[i]
+// (seqs may be NULL).
+uint32_t stepper_queue_push_n(stepper_motor *motor, const stepper_cmd_t *cmds, unsigned n, uint32_t *seqs);
+uint32_t stepper_queue_move_abs(stepper_motor *motor, int32_t abs_stp, uint32_t speed_sps, uint32_t acc_sps2);
+uint32_t stepper_queue_move_rel(stepper_motor *motor, int32_t delta_stp, uint32_t speed_sps, uint32_t acc_sps2);
+uint32_t stepper_queue_dwell(stepper_motor *motor, uint32_t dwell_us);
+uint32_t stepper_queue_homing(stepper_motor *motor, uint32_t speed_sps, uint32_t acc_sps2, int8_t dir);
+uint32_t stepper_queue_set_pos(stepper_motor *motor, int32_t pos_stp);
+uint32_t stepper_queue_enable(stepper_motor *motor, int on);
+
+// 1 once the command with this sequence number (and everything before it) has finished
+int      stepper_seq_done(const stepper_motor *motor, uint32_t seq);
+
+/*
+    Block until command seq has finished, without polling: the RT thread
+    wakes us on the transition itself.
+    Returns:
+      0  done
+     -1  timeout (timeout_ms == 0 waits forever)
+     -2  motor faulted
+*/
+int      stepper_wait_done(stepper_motor *motor, uint32_t seq, uint32_t timeout_ms);
+
+/*
+    Run the edge scheduler, pass monotonic time in microseconds.
+    Moves follow a trapezoidal profile (accel / cruise / decel) computed per
+    step with multiplies only; short moves become triangular. Homing ramps up
+    and cruises until the switch trips.
+
+    Returns 1 while a move or homing is active and stores the absolute time
+    of the next required call in *next_us. Returns 0 when idle: nothing is
+    due until the next command (see cmd_seq / bell).
+    RT thread only.
+*/
+int   stepper_update(stepper_motor *motor, uint32_t now_us, uint32_t *next_us);
+
+// RT thread only, on its way out: de-energise the driver.
+void  stepper_shutdown(stepper_motor *motor);
 
 /*
-    Debug helper: read home/limit switch.
+    Debug helper: read home/limit switch directly. Only while the RT thread
+    is not running; otherwise use stepper_get_status().home_active.
     raw_out: the direct GPIO read (0/1)
     active_out: 1 if raw == motor->home_active_level else 0
     Returns:
@@ -1,21 +1,24 @@
 #include "stepper_thread.h"
+#include "notify.h"
+#include "telemetry.h"
 
 #include <pthread.h>
 #include <time.h>
-#include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
 
 #ifdef __linux__
 #include <sched.h>
 #include <sys/mman.h>
 #endif
 
-static uint32_t now_us(void){
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t us = (uint64_t)(int64_t)ts.tv_sec * 1000000u
-                + (uint64_t)(int64_t)ts.tv_nsec / 1000u;
+// While parked, wake up this often anyway to notice the running flag.
+#define IDLE_WAIT_NS    (100L * 1000L * 1000L)
+
+static uint32_t ts_to_us(const struct timespec *ts){
+    uint64_t us = (uint64_t)(int64_t)ts->tv_sec * 1000000u
+                + (uint64_t)(int64_t)ts->tv_nsec / 1000u;
     return (uint32_t)us;
 }
 
@@ -25,13 +28,66 @@ static void ts_add_ns(struct timespec *t, long ns){
     while (t->tv_nsec < 0)            { t->tv_nsec += 1000000000L; t->tv_sec--; }
 }
 
+static pthread_t th;
+static int th_started;
+
+// mirrors stepper_rt_stats_t; written by the RT thread only
+static struct {
+    _Atomic uint64_t loops, wakeups, idle_wakeups;
+    _Atomic uint64_t wake_hist[STEPPER_RT_HIST_BUCKETS];
+    _Atomic uint64_t exec_hist[STEPPER_RT_HIST_BUCKETS];
+    _Atomic uint64_t wake_min_ns, wake_max_ns, wake_sum_ns, exec_max_ns;
+    _Atomic uint64_t missed, edges, late_edges, edge_late_max_us, edge_late_sum_us, coalesced;
+} rt = { .wake_min_ns = UINT64_MAX };
+
+static uint32_t *trace_buf;
+static size_t trace_cap;
+static _Atomic size_t trace_n;
+
+// single writer: a load and a store, no locked read-modify-write
+static inline void st_inc(_Atomic uint64_t *c){
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1u, memory_order_relaxed);
+}
+
+static inline void st_max(_Atomic uint64_t *c, uint64_t v){
+    if (v > atomic_load_explicit(c, memory_order_relaxed)) atomic_store_explicit(c, v, memory_order_relaxed);
+}
+
+static inline void st_min(_Atomic uint64_t *c, uint64_t v){
+    if (v < atomic_load_explicit(c, memory_order_relaxed)) atomic_store_explicit(c, v, memory_order_relaxed);
+}
+
+static inline void st_add(_Atomic uint64_t *c, uint64_t v){
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+static inline unsigned log2_bucket(uint64_t ns){
+    unsigned b = ns ? (unsigned)(64 - __builtin_clzll(ns)) : 0u;
+    return (b < STEPPER_RT_HIST_BUCKETS) ? b : STEPPER_RT_HIST_BUCKETS - 1u;
+}
+
+static inline uint64_t ts_ns(const struct timespec *t){
+    return (uint64_t)t->tv_sec * 1000000000u + (uint64_t)t->tv_nsec;
+}
+
 typedef struct {
-    const volatile sig_atomic_t *running;
     stepper_motor *m;
+    uint8_t  busy;              // last stepper_update() returned 1
+    uint32_t due_us;            // ... and asked to be called again at this time
+    int      last_state;
+} stp_axis_t;
+
+typedef struct {
+    const volatile sig_atomic_t *running;
+    stp_axis_t ax[STEPPER_THREAD_MAX_AXES];
+    size_t   n;
     int rt_priority;
     int cpu_affinity;
 } stp_thr_args_t;
 
+// every motor on the thread rings this when a command is posted
+static _Atomic uint32_t bell;
+
 static void apply_rt_settings(int rt_priority, int cpu_affinity){
 #ifdef __linux__
     // Prevent paging jitter
@@ -62,30 +118,121 @@ static void apply_rt_settings(int rt_priority, int cpu_affinity){
 #endif
 }
 
+// Run one axis if it is due at now_us (or within the coalescing window, in
+// which case it runs at its own due time so the schedule stays exact).
+static void service_axis(stp_axis_t *x, uint8_t axis, uint32_t now_us, const struct timespec *now){
+    stepper_motor *m = x->m;
+    uint32_t t_us = now_us;
+    if (x->busy) {
+        int32_t ahead = (int32_t)(x->due_us - now_us);
+        if (ahead > (int32_t)STEPPER_RT_COALESCE_US) return;
+        if (ahead > 0) {
+            t_us = x->due_us;
+            st_inc(&rt.coalesced);
+        }
+    } else if (atomic_load_explicit(&m->q_head, memory_order_acquire) ==
+               atomic_load_explicit(&m->q_tail, memory_order_relaxed)) {
+        return;                 // parked and nothing queued
+    }
+
+    uint32_t due = m->next_edge_us;
+    uint8_t level = m->step_level;
+
+    uint32_t next_us;
+    x->busy = (uint8_t)stepper_update(m, t_us, &next_us);
+    x->due_us = next_us;
+
+    if (m->step_level != level && due != 0) {
+        uint32_t late_us = ((int32_t)(now_us - due) > 0) ? now_us - due : 0u;
+        st_inc(&rt.edges);
+        if (late_us > STEPPER_RT_LATE_EDGE_US) st_inc(&rt.late_edges);
+        st_max(&rt.edge_late_max_us, late_us);
+        st_add(&rt.edge_late_sum_us, late_us);
+    }
+
+    if ((int)m->state != x->last_state) {
+        x->last_state = (int)m->state;
+        // cur_period_us is already 0 once a segment ends; the peak of the
+        // segment is what is left to report
+        telemetry_stepper(axis, (uint8_t)x->last_state, m->cur_pos_stp,
+                          stepper_period_to_sps(m->peak_period_us), ts_ns(now));
+    }
+}
+
 static void* stepper_thread_fn(void *p){
     stp_thr_args_t *a = (stp_thr_args_t*)p;
 
     apply_rt_settings(a->rt_priority, a->cpu_affinity);
 
-    // 50 us tick is a good starting point (20 kHz loop),
-    // your step pulses are generated inside stepper_update().
-    const long tick_ns = 50L * 1000L;
+    // No fixed tick: each stepper_update() says when that axis is next due
+    // and we sleep until the earliest of them, so wakeups follow the edges
+    // rather than the number of axes. Edges of other axes falling within
+    // STEPPER_RT_COALESCE_US ride along on the same wakeup. With every axis
+    // idle we park on the bell until a command is posted.
+    while (*(a->running)) {
+        uint32_t seq = atomic_load_explicit(&bell, memory_order_acquire);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint32_t now_us = ts_to_us(&now);
 
-    struct timespec next;
-    clock_gettime(CLOCK_MONOTONIC, &next);
+        for (size_t i = 0; i < a->n; i++) service_axis(&a->ax[i], (uint8_t)i, now_us, &now);
 
-    while (*(a->running)) {
-        // run scheduler
-        stepper_update(a->m, now_us());
-
-        // absolute sleep (prevents drift)
-        ts_add_ns(&next, tick_ns);
-        int rc;
-        do {
-            rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
-        } while (rc == EINTR);
+        struct timespec done;
+        clock_gettime(CLOCK_MONOTONIC, &done);
+        uint64_t exec_ns = ts_ns(&done) - ts_ns(&now);
+        st_inc(&rt.loops);
+        st_inc(&rt.exec_hist[log2_bucket(exec_ns)]);
+        st_max(&rt.exec_max_ns, exec_ns);
+
+        // linear scan: a handful of axes fit in a cache line or two
+        int busy = 0;
+        uint32_t next_us = 0;
+        for (size_t i = 0; i < a->n; i++) {
+            if (!a->ax[i].busy) continue;
+            if (!busy || (int32_t)(a->ax[i].due_us - next_us) < 0) next_us = a->ax[i].due_us;
+            busy = 1;
+        }
+
+        struct timespec deadline = now;
+        if (busy) {
+            int32_t wait_us = (int32_t)(next_us - now_us);
+            if (wait_us <= 0) {
+                st_inc(&rt.missed);
+                continue;
+            }
+            ts_add_ns(&deadline, (long)wait_us * 1000L);
+        } else {
+            ts_add_ns(&deadline, IDLE_WAIT_NS);
+        }
+
+        // absolute deadline; returns early if a new command is posted.
+        // A parked timeout only polls *running: no edge was due, so it is
+        // not a latency sample.
+        int rc = notify_wait(&bell, seq, &deadline);
+        if (rc < 0 && !busy) {
+            st_inc(&rt.idle_wakeups);
+        } else if (rc < 0) {
+            struct timespec woke;
+            clock_gettime(CLOCK_MONOTONIC, &woke);
+            uint64_t w = ts_ns(&woke), d = ts_ns(&deadline);
+            uint64_t lat_ns = (w > d) ? w - d : 0u;
+            st_inc(&rt.wakeups);
+            st_inc(&rt.wake_hist[log2_bucket(lat_ns)]);
+            st_max(&rt.wake_max_ns, lat_ns);
+            st_min(&rt.wake_min_ns, lat_ns);
+            st_add(&rt.wake_sum_ns, lat_ns);
+
+            size_t tn = atomic_load_explicit(&trace_n, memory_order_relaxed);
+            if (tn < trace_cap) {
+                trace_buf[tn] = (lat_ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)lat_ns;
+                atomic_store_explicit(&trace_n, tn + 1u, memory_order_release);
+            }
+        }
     }
 
+    // this thread owns the outputs, so it is the one to switch them off
+    for (size_t i = 0; i < a->n; i++) stepper_shutdown(a->ax[i].m);
     return NULL;
 }
 
@@ -94,13 +241,27 @@ int stepper_thread_start(const volatile sig_atomic_t *running,
                          int rt_priority,
                          int cpu_affinity)
 {
-    static pthread_t th;
+    return stepper_thread_start_axes(running, &m, 1, rt_priority, cpu_affinity);
+}
+
+int stepper_thread_start_axes(const volatile sig_atomic_t *running,
+                              stepper_motor *const *motors, size_t n,
+                              int rt_priority,
+                              int cpu_affinity)
+{
     static stp_thr_args_t args;
 
+    if (th_started || !motors || n == 0 || n > STEPPER_THREAD_MAX_AXES) return -1;
+    for (size_t i = 0; i < n; i++) if (!motors[i]) return -1;
+
     args.running = running;
-    args.m = m;
+    args.n = n;
     args.rt_priority = rt_priority;
     args.cpu_affinity = cpu_affinity;
+    for (size_t i = 0; i < n; i++) {
+        args.ax[i] = (stp_axis_t){ .m = motors[i], .last_state = -1 };
+        motors[i]->bell = &bell;
+    }
 
     pthread_attr_t attr;
     pthread_attr_init(&attr);
@@ -108,5 +269,59 @@ int stepper_thread_start(const volatile sig_atomic_t *running,
     // Larger stack not needed, but keep default.
     int rc = pthread_create(&th, &attr, stepper_thread_fn, &args);
     pthread_attr_destroy(&attr);
+    th_started = (rc == 0);
     return rc;
 }
+
+void stepper_thread_join(void){
+    if (!th_started) return;
+    pthread_join(th, NULL);
+    th_started = 0;
+}
+
+void stepper_thread_get_stats(stepper_rt_stats_t *out){
+    if (!out) return;
+    out->loops   = atomic_load_explicit(&rt.loops, memory_order_relaxed);
+    out->wakeups = atomic_load_explicit(&rt.wakeups, memory_order_relaxed);
+    out->idle_wakeups = atomic_load_explicit(&rt.idle_wakeups, memory_order_relaxed);
+    for (unsigned i = 0; i < STEPPER_RT_HIST_BUCKETS; i++) {
+        out->wake_hist[i] = atomic_load_explicit(&rt.wake_hist[i], memory_order_relaxed);
+        out->exec_hist[i] = atomic_load_explicit(&rt.exec_hist[i], memory_order_relaxed);
+    }
+    out->wake_min_ns      = atomic_load_explicit(&rt.wake_min_ns, memory_order_relaxed);
+    out->wake_max_ns      = atomic_load_explicit(&rt.wake_max_ns, memory_order_relaxed);
+    out->wake_sum_ns      = atomic_load_explicit(&rt.wake_sum_ns, memory_order_relaxed);
+    out->exec_max_ns      = atomic_load_explicit(&rt.exec_max_ns, memory_order_relaxed);
+    out->missed           = atomic_load_explicit(&rt.missed, memory_order_relaxed);
+    out->edges            = atomic_load_explicit(&rt.edges, memory_order_relaxed);
+    out->late_edges       = atomic_load_explicit(&rt.late_edges, memory_order_relaxed);
+    out->edge_late_max_us = atomic_load_explicit(&rt.edge_late_max_us, memory_order_relaxed);
+    out->edge_late_sum_us = atomic_load_explicit(&rt.edge_late_sum_us, memory_order_relaxed);
+    out->coalesced        = atomic_load_explicit(&rt.coalesced, memory_order_relaxed);
+    if (out->wakeups == 0) out->wake_min_ns = 0;
+}
+
+void stepper_thread_trace(uint32_t *buf, size_t n){
+    trace_buf = buf;
+    trace_cap = buf ? n : 0u;
+    atomic_store(&trace_n, 0u);
+}
+
+size_t stepper_thread_trace_len(void){
+    return atomic_load_explicit(&trace_n, memory_order_acquire);
+}
+
+uint64_t stepper_rt_hist_quantile(const uint64_t *hist, double q){
+    uint64_t total = 0;
+    for (unsigned i = 0; i < STEPPER_RT_HIST_BUCKETS; i++) total += hist[i];
+    if (total == 0) return 0;
+
+    uint64_t want = (uint64_t)((double)total * q);
+    if (want >= total) want = total - 1u;
+    uint64_t acc = 0;
+    for (unsigned i = 0; i < STEPPER_RT_HIST_BUCKETS; i++) {
+        acc += hist[i];
+        if (acc > want) return i ? (1ull << i) - 1u : 0u;
+    }
+    return (1ull << (STEPPER_RT_HIST_BUCKETS - 1u)) - 1u;
+}
@@ -2,7 +2,63 @@
 #include <signal.h>
 #include "stepper_driver.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Loop instrumentation, always on. Histograms are log2: bucket i counts
+    values in [2^(i-1), 2^i) ns, bucket 0 counts zero. Single writer (the RT
+    thread), plain relaxed atomics, so readers never stall it.
+*/
+#define STEPPER_RT_HIST_BUCKETS 32u
+#define STEPPER_RT_LATE_EDGE_US 20u     // an edge this late counts as late
+#define STEPPER_RT_COALESCE_US  5u      // edges due this soon share the current wakeup
+#define STEPPER_THREAD_MAX_AXES 8u
+
+typedef struct stepper_rt_stats {
+    uint64_t loops;
+    uint64_t wakeups;               // timed wakeups for a due edge (latency samples)
+    uint64_t idle_wakeups;          // parked timeouts, not counted in the wake stats
+    uint64_t wake_hist[STEPPER_RT_HIST_BUCKETS];    // wake latency, ns past the deadline
+    uint64_t exec_hist[STEPPER_RT_HIST_BUCKETS];    // stepper_update() time, ns
+    uint64_t wake_min_ns;
+    uint64_t wake_max_ns;
+    uint64_t wake_sum_ns;
+    uint64_t exec_max_ns;
+    uint64_t missed;                // next deadline already passed when update returned
+    uint64_t edges;
+    uint64_t late_edges;            // edges written > STEPPER_RT_LATE_EDGE_US after due
+    uint64_t edge_late_max_us;
+    uint64_t edge_late_sum_us;
+    uint64_t coalesced;             // axis updates taken early, on another axis' wakeup
+} stepper_rt_stats_t;
+
 int stepper_thread_start(const volatile sig_atomic_t *running,
                          stepper_motor *m,
                          int rt_priority,     // e.g. 80 (0 disables RT policy)
                          int cpu_affinity);   // e.g. 2 (or -1 = no pin)
+
+/*
+    One RT thread for up to STEPPER_THREAD_MAX_AXES motors (stepper_init()
+    each first). The thread sleeps until the earliest edge due on any axis,
+    so an idle axis costs nothing and a busy one costs its own edges only.
+    One thread per process: a second start fails with -1.
+*/
+int stepper_thread_start_axes(const volatile sig_atomic_t *running,
+                              stepper_motor *const *motors, size_t n,
+                              int rt_priority, int cpu_affinity);
+
+// Wait for the thread to exit after *running drops; it disables every driver on its way out.
+void stepper_thread_join(void);
+
+// Copy the counters; safe at any time while the thread runs.
+void stepper_thread_get_stats(stepper_rt_stats_t *out);
+
+// Value at quantile q (0..1) from a log2 histogram, as the bucket's upper bound in ns.
+uint64_t stepper_rt_hist_quantile(const uint64_t *hist, double q);
+
+// Optional raw trace of wake latencies (ns) for exact percentiles. The RT
+// thread fills buf until it holds n entries, then stops recording. Call
+// before stepper_thread_start(); read the count with stepper_thread_trace_len().
+void   stepper_thread_trace(uint32_t *buf, size_t n);
+size_t stepper_thread_trace_len(void);
@@ -1,4 +1,6 @@
 #include "core.h"
+#include "gpio_backend.h"
+#include "config_watch.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -11,9 +13,16 @@ static void on_sigint(int sigint) {
   running = 0;
 }
 
+static void on_sighup(int sig) {
+  ( void )sig;
+  config_watch_request();
+}
+
 
 int main(void) {
   signal(SIGINT, on_sigint);
+  signal(SIGHUP, on_sighup);
+  gpio_set_backend(&gpio_libgpiod_backend);
   start_core(&running);
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Decode a telemetry ring file (see src/common/telemetry.h) to CSV on stdout,
+// oldest record first.
+//
+//   bin/tlm_decode logs/telemetry.bin > telemetry.csv
+#include "telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *state_name(uint8_t s){
+    // stepper_state_t
+    static const char *names[] = { "UNINIT", "READY", "ENABLED", "MOVING", "HOMING", "FAULT" };
+    return (s < sizeof(names) / sizeof(names[0])) ? names[s] : "?";
+}
+
+int main(int argc, char **argv){
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <telemetry.bin>\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    tlm_header_t h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || h.magic != TLM_MAGIC) {
+        fprintf(stderr, "%s: not a telemetry file\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+    if (h.version != TLM_VERSION || h.rec_size != sizeof(tlm_rec_t) || h.capacity == 0 ||
+        (h.capacity & (h.capacity - 1u)) != 0) {
+        fprintf(stderr, "%s: unsupported version %u / record size %u / capacity %u\n",
+                argv[1], h.version, h.rec_size, h.capacity);
+        fclose(f);
+        return 1;
+    }
+
+    tlm_rec_t *rec = malloc((size_t)h.capacity * sizeof(tlm_rec_t));
+    if (!rec) {
+        fclose(f);
+        return 1;
+    }
+    size_t got = fread(rec, sizeof(tlm_rec_t), h.capacity, f);
+    fclose(f);
+
+    uint64_t head = atomic_load(&h.head);
+    uint64_t first = (head > h.capacity) ? head - h.capacity : 0u;
+    uint64_t skipped = 0;
+
+    printf("seq,t_ns,kind,unit,state,raw,filtered,kg,pos_stp,peak_sps\n");
+    for (uint64_t n = first; n < head; n++) {
+        size_t i = (size_t)(n & (h.capacity - 1u));
+        const tlm_rec_t *r = &rec[i];
+        // torn or never-committed slot (crash mid-record)
+        if (i >= got || atomic_load(&r->seq) != n + 1u) { skipped++; continue; }
+
+        unsigned long long seq = (unsigned long long)(n + 1u);
+        unsigned long long t = (unsigned long long)r->t_ns;
+        switch (r->kind) {
+        case TLM_REC_HX711:
+            if (r->b == TLM_REJECTED) {
+                printf("%llu,%llu,hx711,%u,,%d,rejected,,,\n", seq, t, r->unit, r->a);
+            } else {
+                printf("%llu,%llu,hx711,%u,,%d,%d,%.6f,,\n", seq, t, r->unit, r->a, r->b, (double)r->f);
+            }
+            break;
+        case TLM_REC_STEPPER:
+            printf("%llu,%llu,stepper,%u,%s,,,,%d,%u\n", seq, t, r->unit, state_name(r->state), r->a, (uint32_t)r->b);
+            break;
+        default:
+            skipped++;
+            break;
+        }
+    }
+
+    free(rec);
+    if (skipped) fprintf(stderr, "%llu incomplete record(s) skipped\n", (unsigned long long)skipped);
+    return 0;
+}